@@ -0,0 +1,282 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * gchart-bench.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Microbenchmarks of the chart data and render paths on synthetic series.
+ *
+ * Usage: gchart-bench [--min-points n] [--max-points n] [--output file]
+ *
+ * Series of 1e3, 1e4, ... points up to --max-points (default 1e6, at most 1e8)
+ * are generated and every benchmark reports the median time per operation.
+ * The results are written as JSON to stdout or the output file, progress goes
+ * to stderr. A 1e8 point series needs about 5 GB of memory. */
+
+#include "config.h"
+
+#include <features.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GchartAutoscale.hpp"
+#include "GchartChart.hpp"
+#include "GchartLabel.hpp"
+#include "GchartPoint.hpp"
+#include "GchartProvider.hpp"
+#include "GchartRenderer.hpp"
+#include "GchartSampleQueue.hpp"
+#include "GchartSeries.hpp"
+
+#define RENDER_WIDTH (800)
+#define RENDER_HEIGHT (600)
+/* Every benchmark runs at least this often and for at least this long. */
+#define MIN_RUNS (5)
+#define MIN_TIME (0.2)
+
+struct BenchResult {
+	std::string name;
+	std::size_t points;
+	std::size_t ops;
+	std::size_t runs;
+	double ns_per_op;
+	double min_ns_per_op;
+};
+
+/* Run f (which does ops operations) until MIN_RUNS and MIN_TIME are reached. */
+static BenchResult runBench (const std::string &name, const std::size_t &points, const std::size_t &ops, const std::function<void(void)> &f) {
+	std::vector<double> times;
+	double total = 0;
+
+	f (); // warm up
+	while (times.size () < MIN_RUNS || total < MIN_TIME) {
+		const auto t0 = std::chrono::steady_clock::now ();
+		f ();
+		const double t = std::chrono::duration<double> (std::chrono::steady_clock::now () - t0).count ();
+		times.push_back (t);
+		total += t;
+	}
+	std::sort (times.begin (), times.end ());
+
+	BenchResult r;
+	r.name = name;
+	r.points = points;
+	r.ops = ops;
+	r.runs = times.size ();
+	r.ns_per_op = times[times.size () / 2] * 1e9 / ops;
+	r.min_ns_per_op = times.front () * 1e9 / ops;
+	std::fprintf (stderr, "%-16s %10zu points %14.1f ns/op\n", name.c_str (), points, r.ns_per_op);
+	return r;
+}
+
+static std::shared_ptr<const GchartMap> createSeries (const std::size_t &n) {
+	auto map = std::make_shared<GchartMap> ();
+	uint32_t seed = 12345;
+
+	for (std::size_t i = 0; i < n; ++i) {
+		seed = seed * 1664525u + 1013904223u;
+		const float noise = static_cast<float>(seed >> 8) / (1 << 24) - 0.5f;
+		map->emplace_hint (map->end (), static_cast<float>(i), 100.0f * std::sin (i * 0.001f) + noise);
+	}
+	return map;
+}
+
+/* Keep the compiler from optimising the benchmarked calls away. */
+static volatile float sink;
+
+static void benchSeries (const std::size_t &n, std::vector<BenchResult> &results) {
+	const std::shared_ptr<const GchartMap> map = createSeries (n);
+	const GchartChart chart (GchartChart::Type::LINEAR, 1, {1, 0, 0}, map);
+	auto provider = std::make_shared<GchartProvider> ("y", "", &GchartLabel::defaultPrint);
+	provider->addChart (GchartChart::Type::LINEAR, 1, {1, 0, 0}, map, nullptr);
+	const float x_max = static_cast<float>(n - 1);
+
+	/* Random lookups without hint, a binary search each. */
+	const std::size_t lookups = std::max<std::size_t> (10, std::min<std::size_t> (1000, 100000000 / n));
+	std::vector<float> xs (lookups);
+	uint32_t seed = 54321;
+	for (float &x : xs) {
+		seed = seed * 1664525u + 1013904223u;
+		x = static_cast<float>(seed >> 8) / (1 << 24) * x_max;
+	}
+
+	results.push_back (runBench ("getValue", n, lookups, [&] () {
+		for (const float &x : xs)
+			sink = chart.getValue (x);
+	}));
+
+	/* Cursor readout, every x a little to the right of the one before like a moving mouse. */
+	results.push_back (runBench ("readValue", n, lookups, [&] () {
+		for (std::size_t i = 0; i < lookups; ++i)
+			sink = chart.readValue (x_max / 2 + i * 0.37f);
+	}));
+
+	/* linear () with the iterator of the previous call as hint, as drawChart uses it. */
+	const std::size_t steps = std::min<std::size_t> (n, 1000000);
+	const float step = x_max / steps;
+	results.push_back (runBench ("linear", n, steps, [&] () {
+		GchartMap::const_iterator it = map->end ();
+		for (std::size_t i = 0; i < steps; ++i) {
+			float x = i * step;
+			sink = GchartChart::linear (*map, x, it);
+		}
+	}));
+
+	/* Walk like drawChart () over the whole series with a hint of 1/1000 of the range. */
+	results.push_back (runBench ("getNextPoint", n, n, [&] () {
+		std::shared_ptr<GchartPoint> point, prev = chart.getPoint (0);
+		while ((point = chart.getNextPoint (prev, prev->getX () + x_max / 1000)) != nullptr) {
+			if (!std::isfinite (point->getY ())) break;
+			prev = point;
+		}
+		sink = prev->getY ();
+	}));
+
+	results.push_back (runBench ("getYMin", n, 1, [&] () { sink = provider->getYMin (); }));
+	results.push_back (runBench ("getYMax", n, 1, [&] () { sink = provider->getYMax (); }));
+	results.push_back (runBench ("getYMinRange", n, 1, [&] () { sink = provider->getYMin (x_max / 4, x_max / 2); }));
+	results.push_back (runBench ("getYMaxRange", n, 1, [&] () { sink = provider->getYMax (x_max / 4, x_max / 2); }));
+	/* The same data as a series, its y range is derived once. */
+	GchartProvider series_provider ("y", "", &GchartLabel::defaultPrint);
+	series_provider.addChart (GchartChart::Type::LINEAR, 1, {1, 0, 0}, GchartSeries::create (map), nullptr);
+	results.push_back (runBench ("getYMinSeries", n, 1, [&] () { sink = series_provider.getYMin (0, x_max); }));
+	/* A window of a tenth of the data panned by about a pixel per buffer, like follow mode. */
+	const std::size_t frames = 1000;
+	const float window = x_max / 10, shift = (x_max - window) / frames;
+	results.push_back (runBench ("autoscaleFull", n, frames, [&] () {
+		for (std::size_t i = 0; i < frames; ++i) {
+			sink = provider->getYMin (i * shift, i * shift + window);
+			sink = provider->getYMax (i * shift, i * shift + window);
+		}
+	}));
+	results.push_back (runBench ("autoscale", n, frames, [&] () {
+		GchartAutoscale autoscale;
+		float y_min, y_max;
+		for (std::size_t i = 0; i < frames; ++i) {
+			autoscale.getYRange (*provider, i * shift, i * shift + window, y_min, y_max);
+			sink = y_max - y_min;
+		}
+	}));
+	results.push_back (runBench ("getXMin", n, 1, [&] () { sink = provider->getXMin (); }));
+	results.push_back (runBench ("getXMax", n, 1, [&] () { sink = provider->getXMax (); }));
+
+	GchartRenderer renderer (std::make_shared<GchartLabel> ("x", ""), provider);
+	auto surface = GchartRenderer::createImageSurface (RENDER_WIDTH, RENDER_HEIGHT);
+	results.push_back (runBench ("drawBuffer", n, 1, [&] () { renderer.render (surface, RENDER_WIDTH, RENDER_HEIGHT); }));
+	/* The same without the min/max rasteriser, every sample becomes a path vertex. */
+	renderer.getViewport ().minmax_threshold = 0;
+	results.push_back (runBench ("drawBufferPath", n, 1, [&] () { renderer.render (surface, RENDER_WIDTH, RENDER_HEIGHT); }));
+	renderer.getViewport ().minmax_threshold = GchartViewport ().minmax_threshold;
+	renderer.getViewport ().zoom = 10;
+	results.push_back (runBench ("drawBufferZoom", n, 1, [&] () { renderer.render (surface, RENDER_WIDTH, RENDER_HEIGHT); }));
+}
+
+/* Many small series in one provider, like one series per host. */
+static void benchManySeries (const std::size_t &series, std::vector<BenchResult> &results) {
+	const std::shared_ptr<const GchartMap> map = createSeries (1000);
+	auto provider = std::make_shared<GchartProvider> ("y", "", &GchartLabel::defaultPrint);
+	for (std::size_t i = 0; i < series; ++i)
+		provider->addChart (GchartChart::Type::LINEAR, i, {(i % 2) ? 1.0 : 0.0, 0, (i % 2) ? 0.0 : 1.0}, map, nullptr);
+
+	results.push_back (runBench ("lookupChart", series, series, [&] () {
+		for (std::size_t i = 0; i < series; ++i)
+			sink = (*provider)[i].getColor ()._red;
+	}));
+
+	GchartRenderer renderer (std::make_shared<GchartLabel> ("x", ""), provider);
+	auto surface = GchartRenderer::createImageSurface (RENDER_WIDTH, RENDER_HEIGHT);
+	results.push_back (runBench ("drawBufferSeries", series, 1, [&] () { renderer.render (surface, RENDER_WIDTH, RENDER_HEIGHT); }));
+	renderer.getViewport ().density = true;
+	results.push_back (runBench ("drawBufferDensity", series, 1, [&] () { renderer.render (surface, RENDER_WIDTH, RENDER_HEIGHT); }));
+}
+
+/* One producer thread and the consumer draining as fast as it can, like Gchart::createProducer (). */
+static void benchSampleQueue (const std::size_t &n, std::vector<BenchResult> &results) {
+	GchartSampleQueue queue (1 << 16);
+
+	results.push_back (runBench ("sampleQueue", n, n, [&] () {
+		std::thread producer ([&queue, n] () {
+			for (std::size_t i = 0; i < n;) {
+				if (queue.push (false, 1, static_cast<float>(i), 0))
+					++i;
+			}
+		});
+		std::size_t received = 0;
+		while (received < n)
+			received += queue.drain ([] (const GchartSampleQueue::Sample &s) { sink = s.x; });
+		producer.join ();
+	}));
+}
+
+static void writeJson (FILE *out, const std::vector<BenchResult> &results) {
+	std::fprintf (out, "{\n\t\"package\": \"%s\",\n\t\"version\": \"%s\",\n\t\"time\": %ld,\n\t\"results\": [", PACKAGE_NAME, PACKAGE_VERSION, static_cast<long>(std::time (nullptr)));
+	for (std::size_t i = 0; i < results.size (); ++i) {
+		const BenchResult &r = results[i];
+		std::fprintf (out, "%s\n\t\t{\"name\": \"%s\", \"points\": %zu, \"ops\": %zu, \"runs\": %zu, \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f}",
+			(i > 0) ? "," : "", r.name.c_str (), r.points, r.ops, r.runs, r.ns_per_op, r.min_ns_per_op);
+	}
+	std::fprintf (out, "\n\t]\n}\n");
+}
+
+static void usage (const char *name) {
+	std::fprintf (stderr, "Usage: %s [--min-points n] [--max-points n] [--output file]\n", name);
+}
+
+int main (int argc, char* argv[]) {
+	std::size_t min_points = 1000, max_points = 1000000;
+	const char *output = nullptr;
+
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp (argv[i], "--min-points") == 0 && i + 1 < argc)
+			min_points = std::strtod (argv[++i], nullptr);
+		else if (std::strcmp (argv[i], "--max-points") == 0 && i + 1 < argc)
+			max_points = std::strtod (argv[++i], nullptr);
+		else if (std::strcmp (argv[i], "--output") == 0 && i + 1 < argc)
+			output = argv[++i];
+		else {
+			usage (argv[0]);
+			return 2;
+		}
+	}
+	max_points = std::min<std::size_t> (max_points, 100000000);
+	min_points = std::max<std::size_t> (min_points, 10);
+
+	std::vector<BenchResult> results;
+	for (std::size_t n = min_points; n <= max_points; n *= 10)
+		benchSeries (n, results);
+	benchManySeries (1000, results);
+	benchSampleQueue (1000000, results);
+
+	FILE *out = stdout;
+	if (output != nullptr && (out = std::fopen (output, "w")) == nullptr) {
+		std::fprintf (stderr, "%s: can not write %s\n", argv[0], output);
+		return 1;
+	}
+	writeJson (out, results);
+	if (out != stdout)
+		std::fclose (out);
+	return 0;
+}
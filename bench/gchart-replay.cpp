@@ -0,0 +1,241 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * gchart-replay.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Replays an input trace, recorded with Gchart::startRecording (), offscreen
+ * on synthetic series and reports the frame time percentiles.
+ *
+ * Usage: gchart-replay [--points n] [--series n] [--output file]
+ *                      [--expect-checksum hex] [--max-p95 ms] trace
+ *
+ * Input is coalesced per frame like Gchart::onTick () does: the last pointer
+ * position and the summed scroll deltas are applied, the buffer is rendered
+ * again when the view or the size changed and the cursor and info box are
+ * drawn on top. The checksum of the last frame depends on the installed
+ * fonts, compare it only between runs on the same machine. It exits with 1
+ * when the checksum differs from --expect-checksum or p95 is above --max-p95. */
+
+#include "config.h"
+
+#include <features.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GchartChart.hpp"
+#include "GchartColor.hpp"
+#include "GchartInputTrace.hpp"
+#include "GchartLabel.hpp"
+#include "GchartProvider.hpp"
+#include "GchartRenderer.hpp"
+#include "GchartViewport.hpp"
+
+/* Size used when the trace starts without a resize. */
+#define DEFAULT_WIDTH (800)
+#define DEFAULT_HEIGHT (600)
+
+struct ReplayResult {
+	std::vector<double> frame_times;
+	std::size_t renders;
+	uint64_t checksum;
+};
+
+static std::shared_ptr<const GchartMap> createSeries (const std::size_t &n, const std::size_t &index) {
+	auto map = std::make_shared<GchartMap> ();
+	uint32_t seed = 12345 + index;
+
+	for (std::size_t i = 0; i < n; ++i) {
+		seed = seed * 1664525u + 1013904223u;
+		const float noise = static_cast<float>(seed >> 8) / (1 << 24) - 0.5f;
+		map->emplace_hint (map->end (), static_cast<float>(i), 100.0f * std::sin (i * 0.001f + index) + 10.0f * index + noise);
+	}
+	return map;
+}
+
+/* FNV-1a over the visible pixels, the padding at the end of a row is skipped. */
+static uint64_t checksum (const Cairo::RefPtr<Cairo::ImageSurface> &surface) {
+	uint64_t hash = 14695981039346656037ull;
+
+	surface->flush ();
+	const unsigned char *data = surface->get_data ();
+	for (int y = 0; y < surface->get_height (); ++y) {
+		const unsigned char *row = data + static_cast<std::size_t>(y) * surface->get_stride ();
+		for (int i = 0; i < surface->get_width () * 4; ++i) {
+			hash ^= row[i];
+			hash *= 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+static ReplayResult replay (const GchartInputTrace &trace, GchartRenderer &renderer) {
+	GchartViewport &v = renderer.getViewport ();
+	Cairo::RefPtr<Cairo::ImageSurface> buffer, frame;
+	ReplayResult result;
+	int width = DEFAULT_WIDTH, height = DEFAULT_HEIGHT;
+	double motion_x = 0, motion_y = 0, dx = 0, dy = 0;
+	bool motion = false, scroll = false, dirty = true;
+	float x_pointer = NAN;
+
+	result.renders = 0;
+	result.checksum = 0;
+	for (const GchartInputTrace::Event &e : trace.getEvents ()) {
+		if (e.type == GchartInputTrace::MOTION) {
+			motion_x = e.a;
+			motion_y = e.b;
+			motion = true;
+		} else if (e.type == GchartInputTrace::SCROLL) {
+			dx += e.a;
+			dy += e.b;
+			scroll = true;
+		} else if (e.type == GchartInputTrace::RESIZE) {
+			width = std::max (1, static_cast<int>(e.a));
+			height = std::max (1, static_cast<int>(e.b));
+		} else {
+			const auto t0 = std::chrono::steady_clock::now ();
+
+			if (motion && v.inPlotArea (motion_x, motion_y))
+				x_pointer = v.getXValue (motion_x);
+			if (scroll && std::isfinite (x_pointer)) {
+				v.scroll (dx, dy, x_pointer);
+				dirty = true;
+			}
+			motion = scroll = false;
+			dx = dy = 0;
+
+			if (!buffer || buffer->get_width () != width || buffer->get_height () != height) {
+				buffer = GchartRenderer::createImageSurface (width, height);
+				frame = GchartRenderer::createImageSurface (width, height);
+				dirty = true;
+			}
+			if (dirty) {
+				renderer.render (buffer, width, height);
+				++result.renders;
+				dirty = false;
+			}
+
+			auto cr = Cairo::Context::create (frame);
+			cr->set_source (buffer, 0, 0);
+			cr->paint ();
+			if (std::isfinite (x_pointer)) {
+				GchartRenderer::drawCursor (cr, v, x_pointer);
+				renderer.renderInfo (cr, x_pointer);
+			}
+			frame->flush ();
+
+			result.frame_times.push_back (std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - t0).count ());
+		}
+	}
+	if (frame)
+		result.checksum = checksum (frame);
+	return result;
+}
+
+/* Nearest rank percentile of sorted values. */
+static double percentile (const std::vector<double> &sorted, const double &p) {
+	if (sorted.empty ()) return 0;
+	const std::size_t rank = static_cast<std::size_t>(std::ceil (p / 100 * sorted.size ()));
+	return sorted[std::min (sorted.size (), std::max<std::size_t> (rank, 1)) - 1];
+}
+
+static void usage (const char *name) {
+	std::fprintf (stderr, "Usage: %s [--points n] [--series n] [--output file] [--expect-checksum hex] [--max-p95 ms] trace\n", name);
+}
+
+int main (int argc, char* argv[]) {
+	std::size_t points = 100000, series = 3;
+	const char *output = nullptr, *trace_file = nullptr;
+	const char *expect_checksum = nullptr;
+	double max_p95 = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp (argv[i], "--points") == 0 && i + 1 < argc)
+			points = std::strtod (argv[++i], nullptr);
+		else if (std::strcmp (argv[i], "--series") == 0 && i + 1 < argc)
+			series = std::strtoul (argv[++i], nullptr, 10);
+		else if (std::strcmp (argv[i], "--output") == 0 && i + 1 < argc)
+			output = argv[++i];
+		else if (std::strcmp (argv[i], "--expect-checksum") == 0 && i + 1 < argc)
+			expect_checksum = argv[++i];
+		else if (std::strcmp (argv[i], "--max-p95") == 0 && i + 1 < argc)
+			max_p95 = std::strtod (argv[++i], nullptr);
+		else if (argv[i][0] != '-' && trace_file == nullptr)
+			trace_file = argv[i];
+		else {
+			usage (argv[0]);
+			return 2;
+		}
+	}
+	if (trace_file == nullptr) {
+		usage (argv[0]);
+		return 2;
+	}
+
+	GchartInputTrace trace;
+	if (!trace.load (trace_file)) {
+		std::fprintf (stderr, "%s: can not read trace %s\n", argv[0], trace_file);
+		return 1;
+	}
+
+	auto provider = std::make_shared<GchartProvider> ("y", "", &GchartLabel::defaultPrint);
+	for (std::size_t i = 0; i < std::max<std::size_t> (series, 1); ++i) {
+		const GchartColor color = {(i % 3 == 0) ? 1.0 : 0.0, (i % 3 == 1) ? 1.0 : 0.0, (i % 3 == 2) ? 1.0 : 0.0};
+		provider->addChart (GchartChart::Type::LINEAR, i, color, createSeries (std::max<std::size_t> (points, 2), i), nullptr);
+	}
+	GchartRenderer renderer (std::make_shared<GchartLabel> ("x", ""), provider);
+
+	ReplayResult result = replay (trace, renderer);
+	std::vector<double> sorted = result.frame_times;
+	std::sort (sorted.begin (), sorted.end ());
+	const double p50 = percentile (sorted, 50), p95 = percentile (sorted, 95), p99 = percentile (sorted, 99);
+	const double max = sorted.empty () ? 0 : sorted.back ();
+
+	FILE *out = stdout;
+	if (output != nullptr && (out = std::fopen (output, "w")) == nullptr) {
+		std::fprintf (stderr, "%s: can not write %s\n", argv[0], output);
+		return 1;
+	}
+	std::fprintf (out, "{\n\t\"package\": \"%s\",\n\t\"version\": \"%s\",\n\t\"time\": %ld,\n", PACKAGE_NAME, PACKAGE_VERSION, static_cast<long>(std::time (nullptr)));
+	std::fprintf (out, "\t\"trace\": \"%s\",\n\t\"points\": %zu,\n\t\"series\": %zu,\n\t\"frames\": %zu,\n\t\"renders\": %zu,\n", trace_file, points, series, sorted.size (), result.renders);
+	std::fprintf (out, "\t\"p50_ms\": %.3f,\n\t\"p95_ms\": %.3f,\n\t\"p99_ms\": %.3f,\n\t\"max_ms\": %.3f,\n", p50, p95, p99, max);
+	std::fprintf (out, "\t\"checksum\": \"%016" PRIx64 "\"\n}\n", result.checksum);
+	if (out != stdout)
+		std::fclose (out);
+	std::fprintf (stderr, "%zu frames, %zu renders, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, checksum %016" PRIx64 "\n",
+		sorted.size (), result.renders, p50, p95, p99, result.checksum);
+
+	int ret = 0;
+	if (expect_checksum != nullptr && std::strtoull (expect_checksum, nullptr, 16) != result.checksum) {
+		std::fprintf (stderr, "%s: checksum %016" PRIx64 " differs from %s\n", argv[0], result.checksum, expect_checksum);
+		ret = 1;
+	}
+	if (max_p95 > 0 && p95 > max_p95) {
+		std::fprintf (stderr, "%s: p95 %.3f ms is above %.3f ms\n", argv[0], p95, max_p95);
+		ret = 1;
+	}
+	return ret;
+}
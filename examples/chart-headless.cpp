@@ -0,0 +1,26 @@
+#include "config.h"
+
+#include <features.h>
+#include <map>
+#include <memory>
+
+#include "GchartRenderer.hpp"
+
+int main (int argc, char* argv[])
+{
+	const char *filename = (argc > 1) ? argv[1] : "chart.png";
+	std::map<const float, const float> map1 = {{0,0},{1,10},{2,10},{3,15},{4,5},{5,10},{5,11},{6,0}};
+	std::map<const float, const float> map2 = {{0,100},{1.1,120},{1.5,140},{2,150},{3.1,110},{3.8,80},{4.5,91},{5.1,95},{5.5,105},{6,100}};
+
+	auto label = std::make_shared<GchartLabel> ("afstand", "km");
+	auto y1 = std::make_shared<GchartProvider> ("snelheid", "km/u", &GchartLabel::defaultPrint);
+	auto y2 = std::make_shared<GchartProvider> ("hoogte", "m", &GchartLabel::defaultPrint);
+	y1->addChart (GchartChart::Type::LINEAR, 1, {1, 0, 0}, map1, nullptr);
+	y2->addChart (GchartChart::Type::LINEAR, 1, {0, 1, 0}, map2, nullptr);
+
+	/* No display needed. */
+	GchartRenderer renderer (label, y1, y2);
+	auto surface = renderer.render (700, 700);
+	surface->write_to_png (filename);
+	return 0;
+}
@@ -28,32 +28,56 @@
 #include <cairomm/cairomm.h>
 
 #include "GchartProvider.hpp"
+#include "GchartThreadPool.hpp"
+#include "GchartRenderer.hpp"
+#include "GchartRenderThread.hpp"
+#include "GchartHitIndex.hpp"
+#include "GchartPrefetch.hpp"
+#include "GchartInputTrace.hpp"
+#include "GchartTrace.hpp"
 
 #define PADDING (5)
-#define BORDER_OFFSET (PADDING)
-#define DOT_RADIUS 2.0
-
-#if _ENABLE_GTK == 4
-#define LINECAP_ROUND ROUND
-#define LINECAP_BUTT BUTT
-#define LINEJOIN_ROUND ROUND
-#define LINEJOIN_MITER MITER
-#define ARGB32 ARGB32
-#elif _ENABLE_GTK == 3
-#define LINECAP_ROUND LINE_CAP_ROUND
-#define LINECAP_BUTT LINE_CAP_BUTT
-#define LINEJOIN_ROUND LINE_JOIN_ROUND
-#define LINEJOIN_MITER LINE_JOIN_MITER
-#define ARGB32 FORMAT_ARGB32
-#endif
+/* Milliseconds a slice of RENDER_SLICED may block the main loop. */
+#define SLICE_BUDGET (4.0)
 
 Gchart::Gchart (void) : Glib::ObjectBase ("gchart") {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	this->initialize ();
+}
+
+/* Shared by all constructors, also the one Glade uses. */
+void Gchart::initialize (void) {
 	this->init = false;
 	this->update_buffer = false;
 	this->x_mouse_pointer = NAN;
-	this->plot_lines = true;
-	this->plot_dots = true;
+	this->x_mouse_coord = NAN;
+	this->y_mouse_coord = NAN;
+	this->hit_test = false;
+	this->snap = false;
+	this->render_mode = RENDER_SYNC;
+	this->buffered_width = 0;
+	this->buffered_height = 0;
+	this->pending_motion = false;
+	this->pending_scroll = false;
+	this->pending_x = 0;
+	this->pending_y = 0;
+	this->pending_dx = 0;
+	this->pending_dy = 0;
+	this->tick_id = 0;
+	this->max_fps = 30;
+	this->last_refresh = 0;
+	this->debug_hud = false;
+	this->buffer_stats_new = false;
+	this->frame_time = 0;
+	this->source_request = {NAN, NAN, 0};
+	this->source_serial = 0;
+	this->y1_autoscale = std::make_shared<GchartAutoscale> ();
+	this->y2_autoscale = std::make_shared<GchartAutoscale> ();
+
+	this->render_thread.reset (new GchartRenderThread (&GchartRenderer::drawBuffer));
+	this->prefetch.reset (new GchartPrefetch ());
+	this->render_thread->signal_done ().connect (sigc::mem_fun (*this, &Gchart::onRenderDone));
+	this->prefetch->signal_ready ().connect (sigc::mem_fun (*this, &Gchart::onSourceReady));
 
 #if _ENABLE_GTK == 4
 	m_scroll = Gtk::EventControllerScroll::create ();
@@ -83,12 +107,72 @@ Gchart::Gchart (void) : Glib::ObjectBase ("gchart") {
 
 Gchart::~Gchart (void) {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	this->slice_source.disconnect ();
+	if (this->tick_id != 0)
+		this->remove_tick_callback (this->tick_id);
 }
 
 sigc::signal<void(const float&)> Gchart::signal_mouse_move (void) {
 	return this->_signal_mouse_move;
 }
 
+sigc::signal<void(const GchartStats&)> Gchart::signal_frame_stats (void) {
+	return this->_signal_frame_stats;
+}
+
+const GchartStats& Gchart::getStats (void) const {
+	return this->stats;
+}
+
+void Gchart::setTracing (const bool enable) {
+	GchartTrace::setEnabled (enable);
+}
+
+bool Gchart::dumpTrace (const std::string &filename) {
+	return GchartTrace::getDefault ().dump (filename);
+}
+
+void Gchart::startRecording (void) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	this->recorder.reset (new GchartInputTrace ());
+}
+
+bool Gchart::stopRecording (const std::string &filename) {
+	g_debug("%s:%d %s (%s)", __FILE__, __LINE__, __func__, filename.c_str ());
+	if (!this->recorder) return false;
+	const bool ret = this->recorder->save (filename);
+	this->recorder.reset ();
+	return ret;
+}
+
+void Gchart::setDebugHud (const bool enable) {
+	this->debug_hud = enable;
+	this->queue_draw ();
+}
+
+void Gchart::setRenderMode (const RenderMode &mode) {
+	g_debug("%s:%d %s (%d)", __FILE__, __LINE__, __func__, mode);
+	if (mode == this->render_mode) return;
+	this->cancelRender ();
+	this->render_mode = mode;
+	this->update_buffer = true;
+	this->queue_draw ();
+}
+
+const Gchart::RenderMode& Gchart::getRenderMode (void) const {
+	return this->render_mode;
+}
+
+void Gchart::setLabelCache (const bool x_cache, const bool y1_cache, const bool y2_cache) {
+	g_debug("%s:%d %s (%d, %d, %d)", __FILE__, __LINE__, __func__, x_cache, y1_cache, y2_cache);
+	if (this->label)
+		this->label->setCacheable (x_cache);
+	if (this->y1)
+		this->y1->getLabel ()->setCacheable (y1_cache);
+	if (this->y2)
+		this->y2->getLabel ()->setCacheable (y2_cache);
+}
+
 void Gchart::setLabels (const std::string &x_label, const std::string &x_unit, GchartValuePrint x_print, const std::string &y1_label, const std::string &y1_unit, GchartValuePrint y1_print) {
 	g_debug("%s:%d %s (%s, %s, %p, %s, %s, %p)", __FILE__, __LINE__, __func__, x_label.c_str(), x_unit.c_str(), x_print, y1_label.c_str(), y1_unit.c_str(), y1_print);
 	this->reset (true);
@@ -111,6 +195,7 @@ void Gchart::setLabels (const std::string &x_label, const std::string &x_unit, G
 
 bool Gchart::addY1Chart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const GchartMap chart, GchartGetValue get_value) {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	GchartTraceScope trace ("data", "addY1Chart");
 	bool ret = false;
 	if (this->y1) {
 		ret = this->y1->addChart (t, identifier, color, chart, get_value);
@@ -121,31 +206,188 @@ bool Gchart::addY1Chart (const GchartChart::Type &t, const int &identifier, cons
 
 bool Gchart::addY2Chart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const GchartMap chart, GchartGetValue get_value) {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	GchartTraceScope trace ("data", "addY2Chart");
 	if (this->y2)
 		return this->y2->addChart (t, identifier, color, chart, get_value);
 	return false;
 }
 
+bool Gchart::addY1Chart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const std::shared_ptr<const GchartSeries> &series, GchartGetValue get_value) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	GchartTraceScope trace ("data", "addY1Chart");
+	bool ret = false;
+	if (this->y1) {
+		ret = this->y1->addChart (t, identifier, color, series, get_value);
+		this->init = true;
+	}
+	return ret;
+}
+
+bool Gchart::addY2Chart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const std::shared_ptr<const GchartSeries> &series, GchartGetValue get_value) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	GchartTraceScope trace ("data", "addY2Chart");
+	if (this->y2)
+		return this->y2->addChart (t, identifier, color, series, get_value);
+	return false;
+}
+
+bool Gchart::addY1Source (const int &identifier, const GchartColor &color, const std::shared_ptr<GchartDataSource> &source) {
+	g_debug("%s:%d %s (%d)", __FILE__, __LINE__, __func__, identifier);
+	if (!this->y1 || !this->y1->addSource (identifier, color, source))
+		return false;
+	this->init = true;
+	/* Ask for the current view again, including the new chart. An old
+	 * chart with the same identifier may have left tiles. */
+	this->prefetch->clear ();
+	this->source_request = {NAN, NAN, 0};
+	this->update_buffer = true;
+	this->queue_draw ();
+	return true;
+}
+
+bool Gchart::addY2Source (const int &identifier, const GchartColor &color, const std::shared_ptr<GchartDataSource> &source) {
+	g_debug("%s:%d %s (%d)", __FILE__, __LINE__, __func__, identifier);
+	if (!this->y2 || !this->y2->addSource (identifier, color, source))
+		return false;
+	this->prefetch->clear ();
+	this->source_request = {NAN, NAN, 0};
+	this->update_buffer = true;
+	this->queue_draw ();
+	return true;
+}
+
+void Gchart::setSourceCache (const std::size_t &max_samples) {
+	g_debug("%s:%d %s (%zu)", __FILE__, __LINE__, __func__, max_samples);
+	this->prefetch->setMaxSamples (max_samples);
+}
+
+void Gchart::appendY1 (const int &identifier, const float &x, const float &y) {
+	this->pending_y1[identifier].emplace_hint (this->pending_y1[identifier].end (), x, y);
+	this->requestTick ();
+}
+
+void Gchart::appendY2 (const int &identifier, const float &x, const float &y) {
+	this->pending_y2[identifier].emplace_hint (this->pending_y2[identifier].end (), x, y);
+	this->requestTick ();
+}
+
+void Gchart::setFollow (const float &span, const double &fps) {
+	g_debug("%s:%d %s (%f, %f)", __FILE__, __LINE__, __func__, span, fps);
+	this->viewport.x_span = std::max (span, 0.0f);
+	this->max_fps = fps;
+	this->update_buffer = true;
+	this->queue_draw ();
+}
+
+void Gchart::setDensity (const bool enable) {
+	g_debug("%s:%d %s (%d)", __FILE__, __LINE__, __func__, enable);
+	this->viewport.density = enable;
+	this->update_buffer = true;
+	this->queue_draw ();
+}
+
+void Gchart::setHitTest (const bool enable) {
+	g_debug("%s:%d %s (%d)", __FILE__, __LINE__, __func__, enable);
+	this->hit_test = enable;
+	if (!this->hit_test && !this->snap)
+		this->hits.reset ();
+	this->update_buffer = true;
+	this->queue_draw ();
+}
+
+bool Gchart::hitTest (const double &x_coord, const double &y_coord, GchartHit &hit, const double &max_distance) const {
+	g_debug("%s:%d %s (%lf, %lf)", __FILE__, __LINE__, __func__, x_coord, y_coord);
+	if (!this->hits) return false;
+	return this->hits->find (x_coord, y_coord, max_distance, hit);
+}
+
+void Gchart::setSnap (const bool enable) {
+	g_debug("%s:%d %s (%d)", __FILE__, __LINE__, __func__, enable);
+	this->snap = enable;
+	if (!this->hit_test && !this->snap)
+		this->hits.reset ();
+	this->update_buffer = true;
+	this->queue_draw ();
+}
+
+std::shared_ptr<GchartSampleQueue> Gchart::createProducer (const std::size_t &capacity) {
+	g_debug("%s:%d %s (%zu)", __FILE__, __LINE__, __func__, capacity);
+	auto queue = std::make_shared<GchartSampleQueue> (capacity);
+	this->producers.push_back (queue);
+	this->requestTick ();
+	return queue;
+}
+
+bool Gchart::drainProducers (void) {
+	GchartTraceScope trace ("data", "drainProducers");
+
+	for (auto it = this->producers.begin (); it != this->producers.end ();) {
+		/* Once the thread let go of the queue nothing can be added anymore. */
+		const bool released = (it->use_count () == 1);
+		(*it)->drain ([this] (const GchartSampleQueue::Sample &s) {
+			GchartMap &pending = (s.y2 ? this->pending_y2 : this->pending_y1)[s.identifier];
+			pending.emplace_hint (pending.end (), s.x, s.y);
+		});
+		if (released)
+			it = this->producers.erase (it);
+		else
+			++it;
+	}
+	return !this->producers.empty ();
+}
+
+void Gchart::applyPendingSamples (void) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	GchartTraceScope trace ("data", "applyPendingSamples");
+
+	/* Nothing may read the chart data while it changes. */
+	this->cancelRender ();
+	for (const auto &p : this->pending_y1) {
+		if (this->y1)
+			this->y1->appendSamples (p.first, p.second);
+	}
+	for (const auto &p : this->pending_y2) {
+		if (this->y2)
+			this->y2->appendSamples (p.first, p.second);
+	}
+	this->pending_y1.clear ();
+	this->pending_y2.clear ();
+	this->update_buffer = true;
+	this->queue_draw ();
+}
+
 bool Gchart::removeY1Chart (const int &n) {
 	g_debug("%s:%d %s (%d)", __FILE__, __LINE__, __func__, n);
+	GchartTraceScope trace ("data", "removeY1Chart");
 	return this->y1->removeChart (n);
 }
 
 bool Gchart::removeY2Chart (const int &n) {
 	g_debug("%s:%d %s (%d)", __FILE__, __LINE__, __func__, n);
+	GchartTraceScope trace ("data", "removeY2Chart");
 	return this->y2->removeChart (n);
 }
 
 bool Gchart::reset (const bool confirm) {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
 	if (confirm) {
+		GchartTraceScope trace ("data", "reset");
+		this->cancelRender ();
+		this->buffer.reset ();
 		this->init = false;
-		this->zoom = 1.0;
-		this->x_center = NAN;
+		this->viewport.zoom = 1.0;
+		this->viewport.x_center = NAN;
 		if (this->y1)
 			this->y1->reset (confirm);
 		if (this->y2)
 			this->y2->reset (confirm);
+		this->prefetch->clear ();
+		this->source_request = {NAN, NAN, 0};
+		this->source_shown.clear ();
+		if (this->y1_autoscale)
+			this->y1_autoscale->clear ();
+		if (this->y2_autoscale)
+			this->y2_autoscale->clear ();
 		return true;
 	}
 	return false;
@@ -159,16 +401,22 @@ bool Gchart::onZoom_gtk3 (const GdkEventScroll *e) {
 
 bool Gchart::onZoom (double dx, double dy) {
 	g_debug("%s:%d %s (%lf, %lf)", __FILE__, __LINE__, __func__, dx, dy);
-	if (!std::isfinite (this->x_mouse_pointer)) return true;
-	if (dy == 0) {
-		this->x_center += dx * (this->x_max - this->x_min);
-	} else {
-		this->zoom += -dy;
-		this->x_center = this->x_mouse_pointer;
-	}
+	/* Scroll deltas are summed and applied once per frame in onTick (). */
+	if (this->recorder)
+		this->recorder->add (GchartInputTrace::SCROLL, dx, dy);
+	this->pending_dx += dx;
+	this->pending_dy += dy;
+	this->pending_scroll = true;
+	this->requestTick ();
+	return true;
+}
+
+void Gchart::applyZoom (const double &dx, const double &dy) {
+	g_debug("%s:%d %s (%lf, %lf)", __FILE__, __LINE__, __func__, dx, dy);
+	if (!std::isfinite (this->x_mouse_pointer)) return;
+	this->viewport.scroll (dx, dy, this->x_mouse_pointer);
 	this->update_buffer = true;
 	this->queue_draw ();
-	return true;
 }
 
 #if _ENABLE_GTK == 3
@@ -179,10 +427,25 @@ bool Gchart::onMouseMove_gtk3 (const GdkEventMotion *e) {
 #endif
 
 void Gchart::onMouseMove (const double &x_coord, const double &y_coord) {
+	g_debug("%s:%d %s (%lf, %lf)", __FILE__, __LINE__, __func__, x_coord, y_coord);
+	/* Only the last position of a frame is used, see onTick (). */
+	if (this->recorder)
+		this->recorder->add (GchartInputTrace::MOTION, x_coord, y_coord);
+	this->pending_x = x_coord;
+	this->pending_y = y_coord;
+	this->pending_motion = true;
+	this->requestTick ();
+}
+
+void Gchart::applyMouseMove (const double &x_coord, const double &y_coord) {
 	g_debug("%s:%d %s (%lf, %lf)", __FILE__, __LINE__, __func__, x_coord, y_coord);
 	float x;
 	if (this->inDrawingBox (x_coord, y_coord)) {
-		x = this->x_min + ((x_coord - this->offset_left) / this->x_scale);
+		this->x_mouse_coord = x_coord;
+		this->y_mouse_coord = y_coord;
+		if (this->snap)
+			this->queue_draw ();
+		x = this->viewport.getXValue (x_coord);
 		if (x != this->x_mouse_pointer) {
 			this->x_mouse_pointer = x;
 			this->queue_draw ();
@@ -192,6 +455,47 @@ void Gchart::onMouseMove (const double &x_coord, const double &y_coord) {
 	return;
 }
 
+void Gchart::requestTick (void) {
+	if (this->tick_id == 0)
+		this->tick_id = this->add_tick_callback (sigc::mem_fun (*this, &Gchart::onTick));
+}
+
+bool Gchart::onTick (const Glib::RefPtr<Gdk::FrameClock>& clock) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	GchartTraceScope trace ("input", "tick");
+	/* Keep ticking while other threads can add samples. */
+	bool again = this->drainProducers ();
+
+	/* New samples wait for max_fps and for the buffer that is being rendered,
+	 * so a slow render is finished instead of cancelled over and over. */
+	if (!this->pending_y1.empty () || !this->pending_y2.empty ()) {
+		const gint64 now = clock->get_frame_time ();
+		const bool busy = this->render_thread->isBusy () || this->slice_job;
+		if (!busy && (this->max_fps <= 0 || now - this->last_refresh >= 1000000 / this->max_fps)) {
+			this->applyPendingSamples ();
+			this->last_refresh = now;
+		} else {
+			again = true;
+		}
+	}
+
+	if (this->pending_motion) {
+		this->pending_motion = false;
+		this->applyMouseMove (this->pending_x, this->pending_y);
+	}
+	if (this->pending_scroll) {
+		this->pending_scroll = false;
+		this->applyZoom (this->pending_dx, this->pending_dy);
+		this->pending_dx = 0;
+		this->pending_dy = 0;
+	}
+
+	/* Remove the callback, the next event installs it again. */
+	if (!again)
+		this->tick_id = 0;
+	return again;
+}
+
 #if _ENABLE_GTK == 3
 bool Gchart::onKeyPressed_gtk3 (const GdkEventButton *e) {
 	(void)e;
@@ -200,8 +504,7 @@ bool Gchart::onKeyPressed_gtk3 (const GdkEventButton *e) {
 #endif
 
 bool Gchart::inDrawingBox (const double &x, const double &y) const {
-	if (x >= this->offset_left && x <= (this->get_allocated_width () - this->offset_right) && y >= this->offset_top && y <= (this->get_allocated_height () - this->offset_bottom)) return true;
-	else return false;
+	return this->viewport.inPlotArea (x, y);
 }
 
 bool Gchart::onKeyPressed (guint keyval, guint keycode, Gdk::ModifierType state) {
@@ -219,441 +522,250 @@ bool Gchart::onDraw_gtk3 (const Cairo::RefPtr<Cairo::Context>& cr) {
 void Gchart::onDraw (const Cairo::RefPtr<Cairo::Context>& cr, int width, int height) {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
 	if (!this->init) return;
+	GchartTraceScope trace ("render", "onDraw");
 
-	width = this->get_allocated_width ();
-	height = this->get_allocated_height ();
-
-	if (this->update_buffer || this->buffered_width != width || this->buffered_height != height) {
-		Cairo::RefPtr<Cairo::Surface> ref_surface = cr->get_target ();
-		this->buffer = Cairo::Surface::create (ref_surface, ref_surface->get_content (), width, height);
-		this->drawBuffer (this->buffer);
-		this->update_buffer = false;
-		this->buffered_width = width;
-		this->buffered_height = height;
-	}
-	cr->set_source (this->buffer, 0, 0);
-	cr->paint ();
-
-	if (std::isfinite (this->x_mouse_pointer)) {
-		cr->set_source_rgba (0.3, 0.3, 0.3, 0.4);
-		Gchart::setLineAtributes (cr, 1.0, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_MITER, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_BUTT);
-		cr->move_to (this->getXCoord (this->x_mouse_pointer), this->offset_top);
-		cr->line_to (this->getXCoord (this->x_mouse_pointer), height - this->offset_bottom);
-		cr->stroke ();
-		this->drawInfo (cr, width, height, this->x_mouse_pointer);
+	const uint64_t frame = this->stats.frame + 1;
+	this->stats.clear ();
+	this->stats.frame = frame;
+	{
+		GchartStatsTimer timer (this->stats, GchartStats::STAGE_FRAME);
+		this->drawFrame (cr, this->get_allocated_width (), this->get_allocated_height ());
 	}
+	if (this->recorder)
+		this->recorder->frame (this->get_allocated_width (), this->get_allocated_height ());
+	this->_signal_frame_stats.emit (this->stats);
+	this->frame_time = this->stats.time[GchartStats::STAGE_FRAME];
 	return;
 }
 
-void Gchart::calulateOffsets (const int &width, const int &height) {
+void Gchart::drawFrame (const Cairo::RefPtr<Cairo::Context>& cr, const int &width, const int &height) {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
 
-	/* Get expected text width for the top and left. This is based on the labels on the y-axis */
-	Cairo::TextExtents extents, extents2;
-	std::string text;
-	float info_box_width;
-
-	// Create a temporary surface to calculate the text sizes.
-	auto surface = Cairo::ImageSurface::create (CAIRO_ENUM_NS_SURFACE::Format::ARGB32, width, height);
-	auto layer = Cairo::Context::create (surface);
-
-	text = this->y1->getLabel ()->getValueUnitText (0.0);
-	layer->get_text_extents (text, extents);
-	text.clear();
-	extents.width += PADDING;
-	extents.height += PADDING;
-	this->offset_left = extents.width + BORDER_OFFSET;
-	this->offset_top = extents.height / 2 + BORDER_OFFSET;
-	info_box_width = extents.width;
-
-	/* Get expected text width for the info box */
-	layer->get_text_extents (this->label->getLabel (), extents);
-	extents.width += PADDING;
-	info_box_width = MAX(extents.width, info_box_width);
-
-	layer->get_text_extents (this->y1->getLabel ()->getLabel (), extents);
-	extents.width += PADDING;
-	info_box_width = MAX(extents.width, info_box_width);
-
-	if(this->y2) {
-		layer->get_text_extents (this->y2->getLabel ()->getLabel (), extents);
-		extents.width += PADDING;
-		info_box_width = MAX(extents.width, info_box_width);
-	}
-
-	/* Get expected text width for bottom and right. This is based on the labels on the x-axis */
-	text = this->label->getValueUnitText (0.0);
-
-	layer->get_text_extents (text, extents);
-	text.clear ();
-	if(this->y2) {
-		text = this->y2->getLabel ()->getValueUnitText (0.0);
-		layer->get_text_extents (text, extents2);
-		text.clear ();
-		extents2.width += PADDING;
-		info_box_width = MAX(extents2.width, info_box_width);
-	} else
-		extents2.width = 0;
-	extents.width += PADDING;
-	extents.height += PADDING;
-	info_box_width = MAX(extents.width, info_box_width);
-	this->offset_bottom = extents.height + BORDER_OFFSET;
-	this->infobox_width = info_box_width + 10 * BORDER_OFFSET;
-	this->offset_right = extents.width / 2 + extents2.width + this->infobox_width + BORDER_OFFSET;
-}
-
-void Gchart::drawInfo (const Cairo::RefPtr<Cairo::Context>& layer, const int &width, const int &height, const float &x_info_value) const {
-	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
-
-	float h, offset, n;
-	Cairo::TextExtents extents;
-
-	layer->set_font_size (15);
-	layer->get_text_extents (this->y1->getLabel ()->getLabel (), extents);
-	offset = extents.height / 2 + PADDING;
-
-	n = 1.5;
-	double h_min_y1 = PADDING + extents.height + this->y1->size () * (extents.height + 13 + 2 * PADDING);
-
-	if (this->y2)
-	{
-		double h_min_y2 = PADDING + extents.height + this->y2->size () * (extents.height + 13 + 2 * PADDING);
-		h = std::max (static_cast<double>(height) / 3, h_min_y2);
-		n = 2.5;
-
-		/* Y2 info */
-		layer->set_source_rgba (0, 0, 0, 1);
-		float h_actual = 1.5 * h - (h_min_y2 / 2);
-		Gchart::printText (layer, this->y2->getLabel ()->getLabel (), width - (this->infobox_width / 2), h_actual, MIDDLE_BOTTOM, PADDING / 2);
-		h_actual += extents.height + PADDING;
-		for (const GchartChart &c : *(this->y2.get ())) {
-			const GchartColor& color = c.getColor ();
-			float y_value = c.getValue (x_info_value);
-			layer->set_source_rgba(0, 0, 0, 1);
-			Gchart::printText2 (layer, y_value, this->y2->getLabel (), width - (this->infobox_width / 2), h_actual, MIDDLE_BOTTOM, PADDING / 2);
-			layer->set_source_rgba (color._red, color._green, color._blue, color._alpha);
-			layer->move_to (width - (this->infobox_width / 4) * 3, h_actual + 7);
-			layer->line_to (width - (this->infobox_width / 4), h_actual + 7);
-			layer->stroke ();
-			h_actual += extents.height + 13 + 2 * PADDING;
+	if (this->update_buffer || this->buffered_width != width || this->buffered_height != height || (this->buffer && this->viewport.scale != this->get_scale_factor ())) {
+		std::shared_ptr<GchartRenderJob> job = this->createRenderJob (width, height);
+		if (this->render_mode == RENDER_SLICED) {
+			/* Keep showing the old buffer until the new one has its raster. */
+			this->slice_source.disconnect ();
+			this->slice_job = job;
+			this->slice_source = Glib::signal_idle ().connect (sigc::mem_fun (*this, &Gchart::onRenderSlice));
+		} else if (this->render_mode != RENDER_SYNC) {
+			/* Keep showing the old buffer until the new one is finished. */
+			if (GchartTrace::isEnabled ())
+				GchartTrace::getDefault ().instant ("render", "submit");
+			this->render_thread->submit (job);
+		} else {
+			GchartRenderer::drawBuffer (*job);
+			this->viewport = job->viewport;
+			this->buffer = job->surface;
+			this->reuse = job->reuse;
+			this->hits = job->hits;
+			this->buffer_stats = job->stats;
+			this->buffer_stats_new = true;
+			this->requestSources ();
 		}
-	} else
-		h = std::max (static_cast<double>(height) / 2, h_min_y1);
-
-	/* Y1 info */
-	layer->set_source_rgba (0, 0, 0, 1);
-	float h_actual = 0.5 * h - (h_min_y1 / 2);
-	Gchart::printText (layer, this->y1->getLabel ()->getLabel (), width - (this->infobox_width / 2), h_actual, MIDDLE_BOTTOM, PADDING / 2);
-	h_actual += extents.height + PADDING;
-	for (const GchartChart &c : *(this->y1.get ())) {
-		const GchartColor& color = c.getColor ();
-		float y_value = c.getValue (x_info_value);
-		layer->set_source_rgba(0, 0, 0, 1);
-		Gchart::printText2 (layer, y_value, this->y1->getLabel (), width - (this->infobox_width / 2), h_actual, MIDDLE_BOTTOM, PADDING / 2);
-		layer->set_source_rgba (color._red, color._green, color._blue, color._alpha);
-		layer->move_to (width - (this->infobox_width / 4) * 3, h_actual + 7);
-		layer->line_to (width - (this->infobox_width / 4), h_actual + 7);
-		layer->stroke ();
-		h_actual += extents.height + 13 + 2 * PADDING;
+		this->update_buffer = false;
+		this->buffered_width = width;
+		this->buffered_height = height;
 	}
-
-	/* X info */
-	layer->set_source_rgba (0, 0, 0, 1);
-	Gchart::printText (layer, this->label->getLabel (), width - (this->infobox_width / 2), n * h - offset, MIDDLE_BOTTOM, PADDING / 2);
-	Gchart::printText2 (layer, x_info_value, this->label, width - (this->infobox_width / 2), n * h + offset, MIDDLE_BOTTOM, PADDING / 2);
-
-	layer->fill ();
-}
-
-void Gchart::drawBuffer (Cairo::RefPtr<Cairo::Surface> surface) {
-	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
-	int width, height;
-	int x_lines;
-
-	if (!this->init) return;
-
-	width = this->get_allocated_width ();
-	height = this->get_allocated_height ();
-
-	this->calulateOffsets (width, height);
-
-	this->calculateMinMaxValues (width, height);
-
-	auto layer = Cairo::Context::create (surface);
-
-	this->drawRaster (layer, width, height, x_lines);
-
-	std::vector<double> dashes;
-	layer->set_dash(dashes, 0);
-	this->setLineAtributes (layer, 1.0, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_ROUND, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_ROUND);
-	//layer->set_source_rgba (1, 0, 0, 1);
-	this->drawChart (layer, this->y1, height, (static_cast<float>(x_lines) / 10));
-	if (this->y2) {
-		//layer->set_source_rgba (0, 0.6, 0, 1);
-		drawChart (layer, this->y2, height, (static_cast<float>(x_lines) / 10));
+	if (!this->buffer) return;
+
+	/* Report the buffer stages in the first frame that shows the buffer. */
+	if (this->buffer_stats_new) {
+		for (int i = GchartStats::STAGE_OFFSETS; i <= GchartStats::STAGE_BUFFER; ++i)
+			this->stats.time[i] = this->buffer_stats.time[i];
+		this->stats.addCounters (this->buffer_stats);
+		this->stats.buffer_rendered = true;
+		this->buffer_stats_new = false;
 	}
-}
-
-void Gchart::drawChart (const Cairo::RefPtr<Cairo::Context>& layer, const std::shared_ptr<GchartProvider> &y, const int &height, const float &x_hint = NAN) const {
-	g_debug("%s:%d %s (-, -, %d, %f)", __FILE__, __LINE__, __func__, height, x_hint);
 
-	for (const GchartChart &c : *(y.get ())) {
-		const GchartColor& color = c.getColor ();
-		std::shared_ptr<GchartPoint> point, point_prev;
-
-		layer->begin_new_path ();
-		layer->set_source_rgba (color._red, color._green, color._blue, color._alpha);
-		point = c.getPoint (this->x_min);
-		point_prev = point;
-		this->drawPoint (layer, y, point, height);
-
-		while ((point = c.getNextPoint (point_prev, point_prev->getX () + x_hint)) != nullptr) {
-			point_prev = point;
-
-			if (point->getX () < this->x_min) break;
-			if (point->getX () > this->x_max) break;
-			if (!std::isfinite (point->getX ()) || !std::isfinite (point->getY ())) continue;
+	cr->set_source (this->buffer, 0, 0);
+	cr->paint ();
 
-			this->drawPoint (layer, y, point, height);
+	if (std::isfinite (this->x_mouse_pointer)) {
+		float x_info = this->x_mouse_pointer;
+		{
+			GchartStatsTimer timer (this->stats, GchartStats::STAGE_OVERLAY);
+			GchartHit hit;
+			if (this->snap && this->hitTest (this->x_mouse_coord, this->y_mouse_coord, hit)) {
+				GchartRenderer::drawCrosshair (cr, this->viewport, hit.x_coord, hit.y_coord);
+				x_info = hit.x;
+			} else {
+				GchartRenderer::drawCursor (cr, this->viewport, this->x_mouse_pointer);
+			}
 		}
-
-		point = c.getPoint (this->x_max);
-		this->drawPoint (layer, y, point, height);
+		GchartStatsTimer timer (this->stats, GchartStats::STAGE_INFO);
+		GchartRenderer::drawInfo (cr, this->viewport, this->label, this->y1, this->y2, x_info);
 	}
-}
-
-void Gchart::drawPoint (const Cairo::RefPtr<Cairo::Context>& layer, const std::shared_ptr<GchartProvider> &y, const std::shared_ptr<GchartPoint> &point, const int &height) const {
-	g_debug("%s:%d %s (%f, %f)", __FILE__, __LINE__, __func__, point->getX (), point->getY ());
 
-	double x_coord = this->getXCoord (point->getX ());
-	double y_coord = this->getYCoord (point->getY (), y);
-	if (this->plot_lines) {
-		g_debug("draw line to %f, %f", x_coord, height - y_coord);
-		layer->line_to (x_coord, height - y_coord);
-		layer->stroke();
-	}
-	layer->move_to (x_coord, height - y_coord);
-	if (this->plot_dots) {
-		layer->arc (x_coord, height - y_coord, DOT_RADIUS, 0, 2 * M_PI);
-		layer->fill();
-		layer->stroke ();
-	}
-	layer->move_to (x_coord, height - y_coord);
+	if (this->debug_hud)
+		this->drawHud (cr);
 }
 
-double Gchart::getXCoord (const float &x) const {
+void Gchart::drawHud (const Cairo::RefPtr<Cairo::Context>& cr) const {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
 
-	if (!std::isfinite (x)) return this->offset_left;
-	return this->offset_left + ((x - this->x_min) * this->x_scale);
+	const double line_height = 12;
+	const int n_lines = GchartStats::STAGE_BUFFER + 3;
+	double y = PADDING + line_height;
+
+	cr->save ();
+	cr->set_font_size (10);
+	cr->set_source_rgba (1, 1, 1, 0.8);
+	cr->rectangle (PADDING, PADDING, 170, n_lines * line_height + PADDING);
+	cr->fill ();
+	cr->set_source_rgba (0, 0, 0, 1);
+
+	/* Buffer stages of the last rendered buffer. */
+	for (int i = GchartStats::STAGE_OFFSETS; i <= GchartStats::STAGE_BUFFER; ++i) {
+		const GchartStats::Stage s = static_cast<GchartStats::Stage>(i);
+		GchartRenderer::printText (cr, string_format ("%-8s %9.0f us", GchartStats::getStageName (s), this->buffer_stats.time[i]), 2 * PADDING, y, GchartRenderer::LEFT_BOTTOM, 0);
+		y += line_height;
+	}
+	GchartRenderer::printText (cr, string_format ("points %lu, vertices %lu, columns %lu", static_cast<unsigned long>(this->buffer_stats.points), static_cast<unsigned long>(this->buffer_stats.vertices), static_cast<unsigned long>(this->buffer_stats.columns)), 2 * PADDING, y, GchartRenderer::LEFT_BOTTOM, 0);
+	y += line_height;
+	GchartRenderer::printText (cr, string_format ("allocations %lu", static_cast<unsigned long>(this->buffer_stats.allocations)), 2 * PADDING, y, GchartRenderer::LEFT_BOTTOM, 0);
+	y += line_height;
+	GchartRenderer::printText (cr, string_format ("last frame %6.0f us", this->frame_time), 2 * PADDING, y, GchartRenderer::LEFT_BOTTOM, 0);
+	cr->restore ();
 }
 
-double Gchart::getYCoord (const float &y, const std::shared_ptr<GchartProvider> &y_provider) const {
+void Gchart::onRenderDone (void) {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	GchartTraceScope trace ("render", "renderDone");
+	std::shared_ptr<GchartRenderJob> job = this->render_thread->takeResult ();
+	if (!job || job->isCancelled ()) return;
 
-	if (!std::isfinite (y)) return this->offset_bottom;
-	return this->offset_bottom + ((y - y_provider->_y_min) * y_provider->_y_scale);
+	this->showBuffer (job, true);
 }
 
-void Gchart::calculateMinMaxValues (const int &width, const int &height) {
+bool Gchart::onRenderSlice (void) {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	std::shared_ptr<GchartRenderJob> job = this->slice_job;
+	if (!job) return false;
 
-	float x_min_data, x_max_data, x_span_zoom;
-	// TODO: also check this->y2
-	x_min_data = this->y1->getXMin ();
-	x_max_data = this->y1->getXMax ();
-
-	/* If zoom is bigger than 1.0 then adjust the minimum and maximum x value to it. */
-	if (std::isfinite (this->zoom) && this->zoom > 1.0f) {
-		x_span_zoom = (x_max_data - x_min_data) / ( 2 * this->zoom);
-		/* If x_center is not set, set it to the middle of the real window. */
-		if (!std::isfinite (this->x_center)) {
-			this->x_center = (x_max_data + x_min_data) /  2;
-		} else {
-			/* If x_center was set, check if it is within the minimum and maximum. */
-			this->x_center = MAX(x_min_data + x_span_zoom, this->x_center);
-			this->x_center = MIN(x_max_data - x_span_zoom, this->x_center);
-		}
-		this->x_max = this->x_center + x_span_zoom;
-		this->x_min = this->x_center - x_span_zoom;
-	} else {
-		this->zoom = 1.0;
-		this->x_max = x_max_data;
-		this->x_min = x_min_data;
-	}
-
-	this->x_scale = (width - this->offset_left - this->offset_right) / (this->x_max - this->x_min);
-
-	this->y1->_y_min = this->y1->getYMin (this->x_min, this->x_max);
-	this->y1->_y_max = this->y1->getYMax (this->x_min, this->x_max);
-	this->y1->_y_scale = (height - this->offset_top - this->offset_bottom) / (this->y1->_y_max - this->y1->_y_min);
-
-	if (this->y2) {
-		this->y2->_y_min = this->y2->getYMin (this->x_min, this->x_max);
-		this->y2->_y_max = this->y2->getYMax (this->x_min, this->x_max);
-		this->y2->_y_scale = (height - this->offset_top - this->offset_bottom) / (this->y2->_y_max - this->y2->_y_min);
-	}
-
-	return;
+	const bool done = GchartRenderer::drawBufferSlice (*job, SLICE_BUDGET);
+	if (done)
+		this->slice_job.reset ();
+	/* Show the charts drawn so far, the stats follow when it is finished. */
+	if (done || job->slice.step == GchartRenderSlice::STEP_CHART)
+		this->showBuffer (job, done);
+	return !done;
 }
 
-void Gchart::drawRaster (const Cairo::RefPtr<Cairo::Context>& layer, const int &width, const int &height, int &x_lines) const {
+void Gchart::cancelRender (void) {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
-
-	Cairo::TextExtents extents;
-	int y_lines;
-
-	/* fill the background */
-	layer->set_source_rgb (1, 1, 1);
-	layer->rectangle (0, 0, width, height);
-	layer->fill ();
-
-	/* x and y1 axis */
-	layer->set_source_rgb (0, 0, 0);
-	layer->move_to (this->offset_left, this->offset_top);
-	/* y1-axis */
-	layer->line_to (this->offset_left, height - this->offset_bottom);
-	/* x-axis */
-	layer->line_to (width - this->offset_right, height - this->offset_bottom);
-	/* y2-axis */
-	if (this->y2)
-		layer->line_to(width - this->offset_right, this->offset_top);
-
-	Gchart::setLineAtributes (layer, 1.0, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_MITER, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_BUTT);
-	layer->stroke ();
-
-	layer->get_text_extents ("0", extents);
-	x_lines = (width - this->offset_left - this->offset_right) / (extents.width * 14);
-	y_lines = (height - this->offset_top - this->offset_bottom) / (extents.height * 4);
-
-	for (int j = 1; j < x_lines; j++) {
-		double x = j * ((width - this->offset_left - this->offset_right) / x_lines) + this->offset_left;
-		double value = j * ((this->x_max - this->x_min) / x_lines) + this->x_min;
-		verticalSubLine (layer, value, this->label, x, height - this->offset_bottom, this->offset_top);
+	this->render_thread->cancel ();
+	this->slice_source.disconnect ();
+	this->slice_job.reset ();
+}
+
+void Gchart::showBuffer (const std::shared_ptr<GchartRenderJob> &job, const bool finished) {
+	/* Do not overwrite the view settings that are requested but not rendered yet. */
+	const GchartViewport requested = this->viewport;
+	this->viewport = job->viewport;
+	if (this->update_buffer) {
+		this->viewport.zoom = requested.zoom;
+		this->viewport.x_center = requested.x_center;
+		this->viewport.x_span = requested.x_span;
+		this->viewport.density = requested.density;
+		this->viewport.plot_lines = requested.plot_lines;
+		this->viewport.plot_dots = requested.plot_dots;
 	}
-
-	for(int j = 1; j < y_lines; j++) {
-		double y = height - this->offset_bottom - j * ((height - this->offset_top - this->offset_bottom) / y_lines);
-		double value = j * ((this->y1->_y_max - this->y1->_y_min) / y_lines) + this->y1->_y_min;
-		horizontalSubLine (layer, value, this->y1->getLabel (), this->offset_left, y, width - this->offset_right);
+	this->buffer = job->surface;
+	if (finished) {
+		this->reuse = job->reuse;
+		this->hits = job->hits;
+		this->buffer_stats = job->stats;
+		this->buffer_stats_new = true;
+		this->requestSources ();
 	}
-
-	/* draw the first and last labels on the X axis */
-	this->printText2 (layer, this->x_min, this->label, this->offset_left, height - this->offset_bottom, MIDDLE_TOP, 5);
-	this->printText2 (layer, this->x_max, this->label, width - this->offset_right, height - this->offset_bottom, MIDDLE_TOP, 5);
-
-	/* draw the first and last labels on the Y1 axis */
-	this->printText2 (layer, this->y1->_y_min, this->y1->getLabel (), this->offset_left, height - this->offset_bottom, RIGHT_MIDDLE, 5);
-	this->printText2 (layer, this->y1->_y_max, this->y1->getLabel (), this->offset_left, this->offset_top, RIGHT_MIDDLE, 5);
-
-	if (this->y2) {
-		/* draw the first and last labels on the Y2 axis */
-		this->printText2 (layer, this->y2->_y_min, this->y2->getLabel (), width - this->offset_right, height - this->offset_bottom, LEFT_MIDDLE, 5);
-		this->printText2 (layer, this->y2->_y_max, this->y2->getLabel (), width - this->offset_right, this->offset_top, LEFT_MIDDLE, 5);
-
-		for(int j = 1; j < y_lines; j++) {
-			double y = height - this->offset_bottom - j * ((height - this->offset_top - this->offset_bottom) / y_lines);
-			double value = j * ((this->y2->_y_max - this->y2->_y_min) / y_lines) + this->y2->_y_min;
-			this->printText2 (layer, value, this->y2->getLabel (), width - this->offset_right, y, LEFT_MIDDLE, 5);
-		}
-	}
-
-	layer->set_source_rgba (1, 0, 0, 0.2);
-	layer->fill ();
+	this->queue_draw ();
 }
 
-void Gchart::setLineAtributes (const Cairo::RefPtr<Cairo::Context>& layer, const double &width, const CAIRO_ENUM_NS_CONTEXT::LineJoin &line_join, const CAIRO_ENUM_NS_CONTEXT::LineCap &line_cap) {
-	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+void Gchart::requestSources (void) {
+	const GchartViewport &v = this->viewport;
+	const GchartDataRequest request = {v.x_min, v.x_max, static_cast<int>(v.width - v.offset_left - v.offset_right)};
+	if (!std::isfinite (request.x_min) || !std::isfinite (request.x_max) || request.columns <= 0) return;
+	if (request.x_min == this->source_request.x_min && request.x_max == this->source_request.x_max && request.columns == this->source_request.columns) return;
 
-	layer->set_line_width (width);
-	layer->set_line_join (line_join);
-	layer->set_line_cap (line_cap);
+	g_debug("%s:%d %s (%f, %f, %d)", __FILE__, __LINE__, __func__, request.x_min, request.x_max, request.columns);
+	GchartTraceScope trace ("data", "requestSources");
+	this->source_request = request;
+	this->source_serial++;
+	this->prefetch->observe (request);
+	this->showSources ();
+	this->prefetch->requestAhead (this->y1, this->y2);
 }
 
-void Gchart::drawSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &x1, const double &y1, const double &x2, const double &y2) {
+void Gchart::showSources (void) {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
 
-	std::vector<double> dashes = {6.0};
-	layer->set_source_rgba (0, 0, 0, 0.8);
-	Gchart::setLineAtributes (layer, 0.25, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_MITER, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_BUTT);
-	layer->set_dash(dashes, 0);
-	layer->move_to(x1, y1);
-	layer->line_to(x2, y2);
+	for (int axis = 0; axis < 2; ++axis) {
+		const std::shared_ptr<GchartProvider> &y = (axis == 0) ? this->y1 : this->y2;
+		if (!y) continue;
+		for (const GchartChart &c : *(y.get ())) {
+			if (!c.getSource ()) continue;
+			uint64_t &shown = this->source_shown[std::make_pair (axis == 1, c.getIdentifier ())];
+			GchartMap samples;
+			if (shown == this->source_serial || !this->prefetch->get (axis == 1, c, this->source_request, samples)) continue;
+			shown = this->source_serial;
+			y->setSamples (c.getIdentifier (), samples);
+			this->update_buffer = true;
+		}
+	}
+	if (this->update_buffer)
+		this->queue_draw ();
 }
 
-void Gchart::verticalSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &value, const std::shared_ptr<GchartLabel> &label, const double &x1, const double &y1, const double &y2) {
+void Gchart::onSourceReady (void) {
 	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
-
-	layer->set_source_rgba (0, 0, 0, 1);
-	Gchart::printText2 (layer, value, label, x1, y1, MIDDLE_TOP, 5);
-	Gchart::drawSubLine (layer, x1, y1, x1, y2);
-	layer->stroke ();
-	layer->fill ();
+	GchartTraceScope trace ("data", "sourceReady");
+	if (this->prefetch->takeResults ())
+		this->showSources ();
 }
 
-void Gchart::horizontalSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &value, const std::shared_ptr<GchartLabel> &label, const double &x1, const double &y1, const double &x2) {
-	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
-
-	layer->set_source_rgba (0, 0, 0, 1);
-	Gchart::printText2 (layer, value, label, x1, y1, RIGHT_MIDDLE, 5);
-	Gchart::drawSubLine (layer, x1, y1, x2, y1);
-	layer->stroke ();
-	layer->fill ();
+GchartRenderer Gchart::createRenderer (void) const {
+	GchartRenderer renderer (this->label, this->y1, this->y2);
+	renderer.getViewport () = this->viewport;
+	return renderer;
 }
 
-void Gchart::printText2 (const Cairo::RefPtr<Cairo::Context>& layer, const float &value, const std::shared_ptr<GchartLabel> &label, const float &x, const float &y, const AllignMode &m, const float &padding) {
-	Gchart::printText (layer, label->getValueUnitText (value), x, y, m, padding);
+bool Gchart::exportSvg (const std::string &filename, const double &tolerance) const {
+	g_debug("%s:%d %s (%s, %f)", __FILE__, __LINE__, __func__, filename.c_str (), tolerance);
+	if (!this->init) return false;
+	return this->createRenderer ().exportSvg (filename, this->get_allocated_width (), this->get_allocated_height (), tolerance);
 }
 
-void Gchart::printText (const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text, const float &x, const float &y, const AllignMode &m, const float &padding) {
-	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
-
-	float x_new, y_new;
-	Cairo::TextExtents extents;
-
-	layer->get_text_extents (text, extents);
-	extents.width += 2 * padding;
-	extents.height += 2 * padding;
-	x_new = x;
-	y_new = y;
+bool Gchart::exportPdf (const std::string &filename, const double &tolerance) const {
+	g_debug("%s:%d %s (%s, %f)", __FILE__, __LINE__, __func__, filename.c_str (), tolerance);
+	if (!this->init) return false;
+	return this->createRenderer ().exportPdf (filename, this->get_allocated_width (), this->get_allocated_height (), tolerance);
+}
 
-	switch(m)
-	{
-		case MIDDLE_TOP:
-			x_new -= extents.width / 2;
-			y_new += extents.height;
-			break;
-		case MIDDLE_MIDDLE:
-			x_new -= extents.width / 2;
-			y_new += extents.height / 2;
-			break;
-		case MIDDLE_BOTTOM:
-			x_new -= extents.width / 2;
-			break;
-		case LEFT_TOP:
-			y_new += extents.height;
-			break;
-		case LEFT_MIDDLE:
-			y_new += extents.height / 2;
-			break;
-		case LEFT_BOTTOM:
-			break;
-		case RIGHT_TOP:
-			x_new -= extents.width;
-			y_new += extents.height;
-			break;
-		case RIGHT_MIDDLE:
-			x_new -= extents.width;
-			y_new += extents.height / 2;
-			break;
-		default:
-		case RIGHT_BOTTOM:
-			x_new -= extents.width / 2;
-			break;
-	}
+std::shared_ptr<GchartRenderJob> Gchart::createRenderJob (const int &width, const int &height) const {
+	g_debug("%s:%d %s (%d, %d)", __FILE__, __LINE__, __func__, width, height);
+	auto job = std::make_shared<GchartRenderJob> ();
 
-	layer->move_to (x_new + padding, y_new - padding);
-	layer->show_text (text);
+	job->viewport = this->viewport;
+	job->viewport.width = width;
+	job->viewport.height = height;
+	job->viewport.scale = this->get_scale_factor ();
+	job->label = this->label;
+	/* Copies only hold a reference to the chart data, so this is cheap. */
+	job->y1 = std::make_shared<GchartProvider> (*this->y1);
+	if (this->y2)
+		job->y2 = std::make_shared<GchartProvider> (*this->y2);
+	/* Full resolution on HiDPI displays, like a surface similar to the window. */
+	job->surface = GchartRenderer::createImageSurface (width, height, job->viewport.scale);
+	job->stats.allocations++;
+	if (this->render_mode == RENDER_TILED)
+		job->tiles = GchartThreadPool::getDefault ().size ();
+	if (this->viewport.x_span > 0)
+		job->previous = this->reuse;
+	job->y1_autoscale = this->y1_autoscale;
+	job->y2_autoscale = this->y2_autoscale;
+	job->hit_index = (this->hit_test || this->snap);
+	return job;
 }
 
 #if _ENABLE_GTK == 3
@@ -661,6 +773,8 @@ void Gchart::printText (const Cairo::RefPtr<Cairo::Context>& layer, const std::s
 GType Gchart::gtype = 0;
 
 Gchart::Gchart (GtkDrawingArea *gobj) : Gtk::DrawingArea (gobj) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	this->initialize ();
 }
 
 Glib::ObjectBase *Gchart::wrap_new (GObject *o) {
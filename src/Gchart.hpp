@@ -19,6 +19,8 @@
 #ifndef __GCHART_HPP__
 #define __GCHART_HPP__
 
+#include <map>
+#include <memory>
 #include <gtkmm.h>
 #include <cairomm/cairomm.h>
 
@@ -27,31 +29,92 @@
 #include "GchartPoint.hpp"
 #include "GchartChart.hpp"
 #include "GchartProvider.hpp"
-
-#if _ENABLE_GTK == 4
-#define CAIRO_ENUM_NS_CONTEXT Cairo::Context
-#define CAIRO_ENUM_NS_SURFACE Cairo::Surface
-#elif _ENABLE_GTK == 3
-#define CAIRO_ENUM_NS_CONTEXT Cairo
-#define CAIRO_ENUM_NS_SURFACE Cairo
-#endif
-
+#include "GchartViewport.hpp"
+#include "GchartRenderer.hpp"
+#include "GchartStats.hpp"
+#include "GchartHit.hpp"
+#include "GchartDataSource.hpp"
+#include "GchartSampleQueue.hpp"
+#include "GchartAutoscale.hpp"
+
+/* Not installed, see sources_private_h in Makefile.am. */
+class GchartRenderThread;
+class GchartHitIndex;
+class GchartPrefetch;
+class GchartInputTrace;
+
+/* Interactive widget around GchartRenderer, it adds zooming, panning, the
+ * cursor read out and rendering off the main thread. */
 class Gchart : public Gtk::DrawingArea {
+public:
+	/* RENDER_SYNC (the default) draws the buffer in the draw handler.
+	 * With RENDER_THREADED the buffer is drawn on a worker thread, so the
+	 * GchartGetValue and GchartValuePrint callbacks must be thread safe.
+	 * RENDER_TILED also splits the plot area in vertical strips that are
+	 * drawn in parallel on GchartThreadPool::getDefault ().
+	 * RENDER_SLICED draws the buffer on the main loop from an idle source in
+	 * slices of about 4 ms, for callbacks that are not thread safe. The charts
+	 * show up progressively. */
+	enum RenderMode {
+		RENDER_SYNC = 0,
+		RENDER_THREADED,
+		RENDER_TILED,
+		RENDER_SLICED
+	};
+
 private:
 	std::shared_ptr<GchartProvider> y1, y2;
 
-	float offset_left, offset_right, offset_top, offset_bottom, infobox_width;
-	float x_max, x_min, x_scale;
-	float zoom, x_center;
+	/* View of the buffer that is currently shown, zoom and x_center are the requested values. */
+	GchartViewport viewport;
 	float x_mouse_pointer;
+	/* Device coordinates of the pointer, for hit testing. */
+	double x_mouse_coord, y_mouse_coord;
 
-	bool plot_lines, plot_dots;
 	bool update_buffer, init;
+	RenderMode render_mode;
 
 	std::shared_ptr<GchartLabel> label;
 	int buffered_width, buffered_height;
 
 	Cairo::RefPtr<Cairo::Surface> buffer;
+	std::unique_ptr<GchartRenderThread> render_thread;
+	/* The charts of the last buffer in follow mode, see GchartRenderReuse. */
+	std::shared_ptr<const GchartRenderReuse> reuse;
+	/* The y ranges of the last buffers, moved along with the view. */
+	std::shared_ptr<GchartAutoscale> y1_autoscale, y2_autoscale;
+	/* The samples of the shown buffer, when hit_test or snap is set. */
+	std::shared_ptr<const GchartHitIndex> hits;
+	bool hit_test, snap;
+	/* The buffer that is drawn by onRenderSlice () in RENDER_SLICED mode. */
+	std::shared_ptr<GchartRenderJob> slice_job;
+	sigc::connection slice_source;
+
+	/* Input collected between two frames. */
+	double pending_x, pending_y, pending_dx, pending_dy;
+	bool pending_motion, pending_scroll;
+	guint tick_id;
+	/* Samples to add per chart identifier, applied at most max_fps times a second. */
+	std::map<int, GchartMap> pending_y1, pending_y2;
+	/* Samples from other threads, drained in every frame (see createProducer ()). */
+	std::vector<std::shared_ptr<GchartSampleQueue>> producers;
+	double max_fps;
+	gint64 last_refresh;
+
+	/* stats is the current frame, buffer_stats the last rendered buffer. */
+	GchartStats stats, buffer_stats;
+	bool buffer_stats_new, debug_hud;
+	double frame_time;
+
+	/* Charts with a GchartDataSource: the tile cache, the shown view and the
+	 * serial of the view each chart shows. */
+	std::unique_ptr<GchartPrefetch> prefetch;
+	GchartDataRequest source_request;
+	uint64_t source_serial;
+	std::map<std::pair<bool, int>, uint64_t> source_shown;
+
+	/* Set while the input is recorded, see startRecording (). */
+	std::unique_ptr<GchartInputTrace> recorder;
 
 #if _ENABLE_GTK == 4
 	Glib::RefPtr<Gtk::EventControllerScroll> m_scroll;
@@ -65,6 +128,7 @@ private:
 #endif
 
 	sigc::signal<void(const float&)> _signal_mouse_move;
+	sigc::signal<void(const GchartStats&)> _signal_frame_stats;
 
 public:
 	Gchart (void);
@@ -78,27 +142,73 @@ public:
 
 	bool addY1Chart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const GchartMap chart, GchartGetValue get_value);
 	bool addY2Chart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const GchartMap chart, GchartGetValue get_value);
+	/* Show a series without copying it, it can be shown by other widgets at the same time. */
+	bool addY1Chart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const std::shared_ptr<const GchartSeries> &series, GchartGetValue get_value);
+	bool addY2Chart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const std::shared_ptr<const GchartSeries> &series, GchartGetValue get_value);
+	/* A chart that asks source for the visible samples whenever the view
+	 * changes, the widget only holds the last answer. */
+	bool addY1Source (const int &identifier, const GchartColor &color, const std::shared_ptr<GchartDataSource> &source);
+	bool addY2Source (const int &identifier, const GchartColor &color, const std::shared_ptr<GchartDataSource> &source);
+	/* Keep at most this many samples of the sources in memory (default 2^20),
+	 * see GchartPrefetch. */
+	void setSourceCache (const std::size_t &max_samples);
+	/* Add a sample to a chart, for live data. Samples are collected and added
+	 * in a frame, at most fps times a second (see setFollow ()). They
+	 * should arrive in x order. */
+	void appendY1 (const int &identifier, const float &x, const float &y);
+	void appendY2 (const int &identifier, const float &x, const float &y);
+	/* Let the x axis follow the newest sample with a fixed span, like a strip
+	 * chart, 0 turns it off. Scrolling changes the span. While only the x
+	 * range changes, the old charts are shifted and only the new samples are
+	 * drawn (not in RENDER_SLICED mode). */
+	void setFollow (const float &span, const double &fps = 30);
+	/* A queue for one thread to add samples to any chart without locks, like
+	 * appendY1 () and appendY2 (). It is drained in every frame while the
+	 * thread holds on to it, samples that do not fit are dropped (see
+	 * GchartSampleQueue::getDropped ()). Give every thread its own queue. */
+	std::shared_ptr<GchartSampleQueue> createProducer (const std::size_t &capacity = 1 << 16);
+	/* Draw a density map of where the charts lie instead of every chart, for
+	 * hundreds of overlapping charts (see GchartViewport::density). */
+	void setDensity (const bool enable);
+	/* Index the visible samples with every buffer, so hitTest () finds the
+	 * sample nearest to a position (in widget coordinates) without walking
+	 * the charts. */
+	void setHitTest (const bool enable);
+	bool hitTest (const double &x_coord, const double &y_coord, GchartHit &hit, const double &max_distance = 20) const;
+	/* Snap the cursor to the nearest sample and show a cross hair on it, implies setHitTest (true). */
+	void setSnap (const bool enable);
 	bool removeY1Chart (const int &n);
 	bool removeY2Chart (const int &n);
 	bool reset (const bool confirm = false);
 
 	sigc::signal<void(const float&)> signal_mouse_move (void);
+	/* Emitted after every frame with its timings and counters. */
+	sigc::signal<void(const GchartStats&)> signal_frame_stats (void);
+	const GchartStats& getStats (void) const;
+	/* Record render and data events of all charts, dumpTrace () writes them as
+	 * Chrome trace event JSON (open it in Perfetto or chrome://tracing). */
+	static void setTracing (const bool enable);
+	static bool dumpTrace (const std::string &filename);
+	/* Record the pointer, scroll and size changes per frame, stopRecording ()
+	 * writes them to a file that bench/gchart-replay plays back offscreen. */
+	void startRecording (void);
+	bool stopRecording (const std::string &filename);
+	/* Show the render statistics on top of the chart. */
+	void setDebugHud (const bool enable);
+
+	/* Write the current view as an SVG or PDF document of the widget size, see GchartRenderer::renderVector (). */
+	bool exportSvg (const std::string &filename, const double &tolerance = 0.5) const;
+	bool exportPdf (const std::string &filename, const double &tolerance = 0.5) const;
+
+	void setRenderMode (const RenderMode &mode);
+	const RenderMode& getRenderMode (void) const;
+	/* Cache the formatted axis values, only for GchartValuePrint callbacks that always
+	 * return the same text for a value. Call it after setLabels (). */
+	void setLabelCache (const bool x_cache, const bool y1_cache, const bool y2_cache = false);
 
 	static void register_type (void);
 
 protected:
-	enum AllignMode {
-		RIGHT_BOTTOM = 0, // default
-		MIDDLE_TOP = 1,
-		MIDDLE_MIDDLE,
-		MIDDLE_BOTTOM,
-		LEFT_TOP,
-		LEFT_MIDDLE,
-		LEFT_BOTTOM,
-		RIGHT_TOP,
-		RIGHT_MIDDLE
-	};
-
 #if _ENABLE_GTK == 3
 	bool onDraw_gtk3 (const Cairo::RefPtr<Cairo::Context>& cr);
 	bool onZoom_gtk3 (const GdkEventScroll *e);
@@ -108,28 +218,32 @@ protected:
 
 	bool onZoom (double dx, double dy);
 	void onMouseMove (const double &x_coord, const double &y_coord);
+	void applyZoom (const double &dx, const double &dy);
+	void applyMouseMove (const double &x_coord, const double &y_coord);
+	void requestTick (void);
+	/* Move the samples of the producers to pending_y1 and pending_y2, returns true while there are producers. */
+	bool drainProducers (void);
+	void applyPendingSamples (void);
+	bool onTick (const Glib::RefPtr<Gdk::FrameClock>& clock);
 	bool onKeyPressed (guint keyval, guint keycode, Gdk::ModifierType state);
 
+	void initialize (void);
 	bool inDrawingBox (const double &x, const double &y) const;
 
 	void onDraw (const Cairo::RefPtr<Cairo::Context>& cr, int width, int height);
-	void calulateOffsets (const int &width, const int &height);
-	void drawInfo (const Cairo::RefPtr<Cairo::Context>& layer, const int &width, const int &height, const float &x_info_value) const;
-	void drawBuffer (Cairo::RefPtr<Cairo::Surface> surface);
-	void drawChart (const Cairo::RefPtr<Cairo::Context>& layer, const std::shared_ptr<GchartProvider> &y, const int &height, const float &x_hint) const;
-	void drawPoint (const Cairo::RefPtr<Cairo::Context>& layer, const std::shared_ptr<GchartProvider> &y, const std::shared_ptr<GchartPoint> &point, const int &height) const;
-
-	double getXCoord (const float &x) const;
-	double getYCoord (const float &y, const std::shared_ptr<GchartProvider> &y_provider) const;
-	void calculateMinMaxValues (const int &width, const int &height);
-	void drawRaster (const Cairo::RefPtr<Cairo::Context>& layer, const int &width, const int &height, int &x_lines) const;
-
-	static void setLineAtributes (const Cairo::RefPtr<Cairo::Context>& layer, const double &width, const CAIRO_ENUM_NS_CONTEXT::LineJoin &line_join, const CAIRO_ENUM_NS_CONTEXT::LineCap &line_cap);
-	static void drawSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &x1, const double &y1, const double &x2, const double &y2);
-	static void verticalSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &value, const std::shared_ptr<GchartLabel> &label, const double &x1, const double &y1, const double &y2);
-	static void horizontalSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &value, const std::shared_ptr<GchartLabel> &label, const double &x1, const double &y1, const double &x2);
-	static void printText2 (const Cairo::RefPtr<Cairo::Context>& layer, const float &value, const std::shared_ptr<GchartLabel> &label, const float &x, const float &y, const Gchart::AllignMode &m, const float &padding);
-	static void printText (const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text, const float &x, const float &y, const Gchart::AllignMode &m, const float &padding);
+	void drawFrame (const Cairo::RefPtr<Cairo::Context>& cr, const int &width, const int &height);
+	void drawHud (const Cairo::RefPtr<Cairo::Context>& cr) const;
+	void onRenderDone (void);
+	/* Ask the data sources for the samples of the shown view, if it changed. */
+	void requestSources (void);
+	/* Show the shown view of every source chart, when its tiles are there. */
+	void showSources (void);
+	void onSourceReady (void);
+	bool onRenderSlice (void);
+	void showBuffer (const std::shared_ptr<GchartRenderJob> &job, const bool finished);
+	void cancelRender (void);
+	std::shared_ptr<GchartRenderJob> createRenderJob (const int &width, const int &height) const;
+	GchartRenderer createRenderer (void) const;
 };
 
 #endif /* __GCHART_HPP__ */
\ No newline at end of file
@@ -0,0 +1,106 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartAutoscale.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartAutoscale.hpp"
+
+#include <cmath>
+#include <mutex>
+
+#include "GchartTrace.hpp"
+
+GchartAutoscale::GchartAutoscale (void) : _revision(0), _x_min(NAN), _x_max(NAN), _valid(false) {
+}
+
+GchartAutoscale::~GchartAutoscale (void) {
+	return;
+}
+
+void GchartAutoscale::getYRange (const GchartProvider &y, const float &x_min, const float &x_max, float &y_min, float &y_max) {
+	GchartTraceScope trace ("data", "autoscale");
+	std::lock_guard<std::mutex> lock (this->_mutex);
+
+	/* The deques only slide forward, anything else reads the window again. */
+	if (!this->_valid || y._revision != this->_revision || x_min < this->_x_min || x_max < this->_x_max || x_min > this->_x_max)
+		this->_windows.clear ();
+	this->_revision = y._revision;
+	this->_x_min = x_min;
+	this->_x_max = x_max;
+	this->_valid = true;
+
+	y_min = NAN;
+	y_max = NAN;
+	for (const GchartChart &c : y) {
+		Window &w = this->_windows[c.getIdentifier ()];
+		float c_min, c_max;
+
+		if (c.getSeries () && c.size () > 0 && x_min <= c.begin ()->first && x_max >= c.last ()->first) {
+			/* The whole series is in the window, its range is known already. */
+			w = Window ();
+			w.series = true;
+			c_min = c.getSeries ()->getYMin ();
+			c_max = c.getSeries ()->getYMax ();
+		} else {
+			if (w.series)
+				w = Window ();
+
+			/* Add the samples that entered the window at the right. */
+			const bool resume = (w.started && w.x_last >= x_min);
+			GchartMap::const_iterator it = c.lowerBound (resume ? w.x_last : x_min);
+			if (resume && it != c.end () && (*it).first == w.x_last)
+				++it;
+			for (; it != c.end () && (*it).first <= x_max; ++it) {
+				const float &x = (*it).first;
+				const float &v = (*it).second;
+				w.x_last = x;
+				w.started = true;
+				if (!std::isfinite (v)) continue;
+				while (!w.min.empty () && w.min.back ().second >= v)
+					w.min.pop_back ();
+				w.min.emplace_back (x, v);
+				while (!w.max.empty () && w.max.back ().second <= v)
+					w.max.pop_back ();
+				w.max.emplace_back (x, v);
+			}
+
+			/* Drop the samples that left it at the left. */
+			while (!w.min.empty () && w.min.front ().first < x_min)
+				w.min.pop_front ();
+			while (!w.max.empty () && w.max.front ().first < x_min)
+				w.max.pop_front ();
+
+			c_min = w.min.empty () ? NAN : w.min.front ().second;
+			c_max = w.max.empty () ? NAN : w.max.front ().second;
+		}
+
+		if (std::isfinite (c_min) && (!std::isfinite (y_min) || c_min < y_min))
+			y_min = c_min;
+		if (std::isfinite (c_max) && (!std::isfinite (y_max) || c_max > y_max))
+			y_max = c_max;
+	}
+}
+
+void GchartAutoscale::clear (void) {
+	std::lock_guard<std::mutex> lock (this->_mutex);
+	this->_valid = false;
+	this->_windows.clear ();
+}
@@ -0,0 +1,69 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartAutoscale.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __GCHART_AUTOSCALE_HPP__
+#define __GCHART_AUTOSCALE_HPP__
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "GchartProvider.hpp"
+
+/* The y range of a provider in an x window that moves a little between
+ * buffers, like a pan or a chart in follow mode. Every chart keeps the
+ * samples of the window that can still become the minimum or the maximum
+ * (monotonic deques), so moving the window only adds the samples that enter
+ * it and drops the ones that leave it. The window is read again from the
+ * data when the charts changed (see GchartProvider::_revision), when a side
+ * moves back (zooming in, panning back) or when it jumps past the old one.
+ * A job can use it from any thread. */
+class GchartAutoscale {
+private:
+	struct Window {
+		/* (x, y) with y increasing in min and decreasing in max, the front is the extreme. */
+		std::deque<std::pair<float, float>> min, max;
+		/* The last sample added, the next update starts after it. */
+		float x_last;
+		bool started;
+		/* The y range was taken from the series of the chart, min and max are empty. */
+		bool series;
+
+		Window (void) : x_last(0), started(false), series(false) {};
+	};
+
+	std::mutex _mutex;
+	uint64_t _revision;
+	float _x_min, _x_max;
+	bool _valid;
+	std::unordered_map<int, Window> _windows;
+
+public:
+	GchartAutoscale (void);
+	~GchartAutoscale (void);
+
+	/* The same range as y.getYMin (x_min, x_max) and y.getYMax (x_min, x_max),
+	 * but for finite samples only. */
+	void getYRange (const GchartProvider &y, const float &x_min, const float &x_max, float &y_min, float &y_max);
+	void clear (void);
+};
+
+#endif /* __GCHART_AUTOSCALE_HPP__ */
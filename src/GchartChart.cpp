@@ -30,13 +30,21 @@
 
 #include "GchartPoint.hpp"
 
+/* readValue () does a binary search when x is further away than this many samples. */
+#define READOUT_STEPS (8)
+
 // For linear inerpolation
-GchartChart::GchartChart (const int identifier, const GchartColor &color, const GchartMap map) : _identifier(identifier), _color(color), _map(map), _get_value(&GchartChart::linear), _user_data(nullptr) {
+GchartChart::GchartChart (const int identifier, const GchartColor &color, const GchartMap map) : _identifier(identifier), _color(color), _map(std::make_shared<const GchartMap> (map)), _get_value(&GchartChart::linear), _user_data(nullptr), _owned(false), _cursor(this->_map->end ()) {
 	return;
 }
 
 // for curved chart
-GchartChart::GchartChart (const GchartChart::Type &t, const int identifier, const GchartColor &color, const GchartMap map, GchartGetValue cb, void *user_data) : _identifier(identifier), _color(color), _map(map) {
+GchartChart::GchartChart (const GchartChart::Type &t, const int identifier, const GchartColor &color, const GchartMap map, GchartGetValue cb, void *user_data) : GchartChart (t, identifier, color, std::make_shared<const GchartMap> (map), cb, user_data) {
+	return;
+}
+
+// shares the data with the caller
+GchartChart::GchartChart (const GchartChart::Type &t, const int identifier, const GchartColor &color, const std::shared_ptr<const GchartMap> &map, GchartGetValue cb, void *user_data) : _identifier(identifier), _color(color), _map(map), _owned(false), _cursor(map->end ()) {
 	switch (t) {
 		case Type::LINEAR:
 			this->_get_value = &GchartChart::linear;
@@ -65,30 +73,88 @@ GchartChart::GchartChart (const GchartChart::Type &t, const int identifier, cons
 	}
 }
 
+// linear chart of the data of source
+GchartChart::GchartChart (const int identifier, const GchartColor &color, const std::shared_ptr<GchartDataSource> &source) : GchartChart (identifier, color, GchartMap ()) {
+	this->_source = source;
+}
+
+// shares the series
+GchartChart::GchartChart (const GchartChart::Type &t, const int identifier, const GchartColor &color, const std::shared_ptr<const GchartSeries> &series, GchartGetValue cb, void *user_data) : GchartChart (t, identifier, color, series->getMap (), cb, user_data) {
+	this->_series = series;
+}
+
 GchartChart::~GchartChart (void) {
 	return;
 }
 
 const float& GchartChart::operator[] (std::size_t idx) const {
-	const auto it = std::next (this->_map.begin (), idx);
+	const auto it = std::next (this->_map->begin (), idx);
 	return (*it).second;
 }
 
 float GchartChart::getValue (const float &x) const {
-	auto it = this->_map.end ();
+	auto it = this->_map->end ();
 	float x_hint = x;
-	float y = this->_get_value (this->_map, x_hint, it);
+	float y = this->_get_value (*this->_map, x_hint, it);
 	if (x_hint == x) return y;
 	return NAN;
 }
 
+float GchartChart::readValue (const float &x) const {
+	if (this->_get_value != &GchartChart::linear || this->_map->empty ())
+		return this->getValue (x);
+
+	const GchartMap &map = *this->_map;
+	GchartMap::const_iterator it = this->_cursor;
+	GchartMap::const_iterator next;
+	int steps = 0;
+
+	/* Walk from the previous readout to the last sample at or before x. */
+	if (it != map.end ()) {
+		while (steps < READOUT_STEPS && (*it).first > x && it != map.begin ()) {
+			--it;
+			++steps;
+		}
+		while (steps < READOUT_STEPS && (*it).first <= x && (next = std::next (it)) != map.end () && (*next).first <= x) {
+			it = next;
+			++steps;
+		}
+	}
+	if (it == map.end () || steps >= READOUT_STEPS) {
+		it = map.upper_bound (x);
+		if (it != map.begin ())
+			--it;
+	}
+	this->_cursor = it;
+
+	if ((*it).first == x)
+		return (*it).second;
+	next = std::next (it);
+	if ((*it).first > x || next == map.end ())
+		return NAN;
+	return (x - (*it).first) * ((*next).second - (*it).second) / ((*next).first - (*it).first) + (*it).second;
+}
+
 float GchartChart::getValue (float &x, GchartMap::const_iterator &it) const {
-	return this->_get_value (this->_map, x, it);
+	return this->_get_value (*this->_map, x, it);
 }
 
 const std::shared_ptr<GchartPoint> GchartChart::getPoint (const float &x) const {
-	const float y = this->getValue (x);
-	return std::make_shared<GchartPoint>(x, y, this->_map.end ());
+	/* Other types and custom callbacks interpolate themselves and start without a hint. */
+	if (this->_get_value != &GchartChart::linear)
+		return std::make_shared<GchartPoint>(x, this->getValue (x), this->_map->end ());
+
+	/* Binary search, so a walk can start anywhere in a large chart. The
+	 * iterator is the sample before x, getNextPoint () continues from it. */
+	GchartMap::const_iterator it = this->_map->lower_bound (x);
+	if (it != this->_map->end () && (*it).first == x)
+		return std::make_shared<GchartPoint>(x, (*it).second, it);
+	if (it == this->_map->begin () || it == this->_map->end ())
+		return std::make_shared<GchartPoint>(x, NAN, this->_map->end ());
+
+	const GchartMap::const_iterator prev = std::prev (it);
+	const float y = (x - (*prev).first) * ((*it).second - (*prev).second) / ((*it).first - (*prev).first) + (*prev).second;
+	return std::make_shared<GchartPoint>(x, y, prev);
 }
 
 const int& GchartChart::getIdentifier (void) const {
@@ -103,54 +169,105 @@ const std::shared_ptr<GchartPoint> GchartChart::getNextPoint (const std::shared_
 }
 
 size_t GchartChart::size (void) const noexcept {
-	return this->_map.size ();
+	return this->_map->size ();
 }
 
 const GchartMap::const_iterator GchartChart::end (void) const noexcept {
-	return this->_map.end ();
+	return this->_map->end ();
 }
 
 const GchartMap::const_iterator GchartChart::begin (void) const noexcept {
-	return this->_map.begin ();
+	return this->_map->begin ();
 }
 
 const GchartMap::const_iterator GchartChart::last (void) const {
-	GchartMap::const_iterator it = this->_map.end ();
+	GchartMap::const_iterator it = this->_map->end ();
 	return --it;
 }
 
+const GchartMap::const_iterator GchartChart::lowerBound (const float &x) const {
+	return this->_map->lower_bound (x);
+}
+
 const GchartColor& GchartChart::getColor (void) const {
 	return this->_color;
 }
 
+void GchartChart::append (const GchartMap &samples) {
+	std::shared_ptr<GchartMap> map;
+
+	if (this->_owned && this->_map.use_count () == 1) {
+		map = std::const_pointer_cast<GchartMap> (this->_map);
+	} else {
+		map = std::make_shared<GchartMap> (*this->_map);
+		this->_owned = true;
+	}
+	/* Samples are expected in x order, then the hint makes every insert O(1). */
+	for (const auto &s : samples)
+		map->emplace_hint (map->end (), s.first, s.second);
+	this->_map = map;
+	this->_series.reset ();
+	this->_cursor = map->end ();
+}
+
+void GchartChart::setSamples (const GchartMap &samples) {
+	this->_map = std::make_shared<GchartMap> (samples);
+	this->_series.reset ();
+	this->_owned = true;
+	this->_cursor = this->_map->end ();
+}
+
+const std::shared_ptr<GchartDataSource>& GchartChart::getSource (void) const {
+	return this->_source;
+}
+
+const std::shared_ptr<const GchartSeries>& GchartChart::getSeries (void) const {
+	return this->_series;
+}
+
+float GchartChart::getXMin (void) const {
+	if (this->_source)
+		return this->_source->getXMin ();
+	if (this->_map->empty ())
+		return NAN;
+	return this->_map->begin ()->first;
+}
+
+float GchartChart::getXMax (void) const {
+	if (this->_source)
+		return this->_source->getXMax ();
+	if (this->_map->empty ())
+		return NAN;
+	return this->last ()->first;
+}
+
 float GchartChart::linear (const GchartMap &map, float &x, GchartMap::const_iterator &it) {
-	float x1 = NAN;
-	float y1 = NAN;
+	GchartMap::const_iterator next;
 
-	if (it != map.end ()) {
-		++it;
-		if (it == map.end ()) {
-			it = map.begin ();
-		} else if ((*it).first < x) {
+	if (it != map.end () && (*it).first <= x) {
+		/* it is the sample before the previous x, walk on from there and never skip a sample. */
+		next = std::next (it);
+		if (next != map.end () && (*next).first < x) {
+			it = next;
 			x = (*it).first;
 			return (*it).second;
 		}
-	} else
-		it = map.begin ();
-
-	for (; it != map.end (); ++it) {
-		const auto &v = *it;
-		if (v.first == x) {
-			return v.second;
-		} else if (v.first < x) {
-			x1 = v.first;
-			y1 = v.second;
-		} else {
-			--it;
-			return (x - x1) * (v.second - y1) / (v.first - x1) + y1;
-		}
+	} else {
+		/* No hint, binary search. */
+		next = map.lower_bound (x);
 	}
-	return NAN;
+
+	/* next is the first sample at or after x, it becomes the sample before x. */
+	if (next != map.end () && (*next).first == x) {
+		it = next;
+		return (*next).second;
+	}
+	if (next == map.end () || next == map.begin ()) {
+		it = map.end ();
+		return NAN;
+	}
+	it = std::prev (next);
+	return (x - (*it).first) * ((*next).second - (*it).second) / ((*next).first - (*it).first) + (*it).second;
 }
 
 float GchartChart::curved2 (const GchartMap &map, float &x, GchartMap::const_iterator &it) {
@@ -24,7 +24,9 @@
 #include <map>
 
 #include "GchartColor.hpp"
+#include "GchartDataSource.hpp"
 #include "GchartPoint.hpp"
+#include "GchartSeries.hpp"
 #include "helper.hpp"
 
 typedef float (*GchartGetValue) (const GchartMap &chart, float &x, GchartMap::const_iterator &it);
@@ -33,9 +35,18 @@ class GchartChart {
 private:
 	const int _identifier;
 	const GchartColor _color;
-	const GchartMap _map;
+	// The data is never changed, so copies of a chart share it.
+	std::shared_ptr<const GchartMap> _map;
+	/* The series _map belongs to, for its derived values. Reset when the data changes. */
+	std::shared_ptr<const GchartSeries> _series;
 	GchartGetValue _get_value;
 	void *_user_data;
+	/* _map was created by append (), so it may be changed when it is not shared. */
+	bool _owned;
+	/* The sample before the x of the last readValue (), or end (). */
+	mutable GchartMap::const_iterator _cursor;
+	/* When set the data is only the part of the source that was asked for last. */
+	std::shared_ptr<GchartDataSource> _source;
 
 
 public:
@@ -52,15 +63,26 @@ public:
 	GchartChart (const int identifier, const GchartColor &color, const GchartMap map);
 	// for curved chart
 	GchartChart (const GchartChart::Type &t, const int identifier, const GchartColor &color, const GchartMap map, GchartGetValue cb = nullptr, void *user_data = nullptr);
+	// shares the data with the caller, so many charts can use the same data without copying it
+	GchartChart (const GchartChart::Type &t, const int identifier, const GchartColor &color, const std::shared_ptr<const GchartMap> &map, GchartGetValue cb = nullptr, void *user_data = nullptr);
+	// linear chart of the data of source, it starts without samples, see setSamples ()
+	GchartChart (const int identifier, const GchartColor &color, const std::shared_ptr<GchartDataSource> &source);
+	// shares the series, with its derived values, with the caller and every other chart of it
+	GchartChart (const GchartChart::Type &t, const int identifier, const GchartColor &color, const std::shared_ptr<const GchartSeries> &series, GchartGetValue cb = nullptr, void *user_data = nullptr);
 	~GchartChart (void);
 
 	const float& operator[] (std::size_t idx) const;
 	float getValue (const float &x) const;
+	/* Like getValue (), for a cursor readout: the search starts at the sample
+	 * of the previous call, so nearby x values take a few steps instead of a
+	 * binary search. Not thread safe, every chart object has its own cursor. */
+	float readValue (const float &x) const;
 
 private:
 	float getValue (float &x, GchartMap::const_iterator &it) const;
 
 public:
+	/* The point at x, interpolated linearly between the samples around it. */
 	const std::shared_ptr<GchartPoint> getPoint (const float &x) const;
 	const int& getIdentifier (void) const;
 	const std::shared_ptr<GchartPoint> getNextPoint (const std::shared_ptr<GchartPoint> &prev, const float &x_hint) const;
@@ -68,8 +90,25 @@ public:
 	const GchartMap::const_iterator end (void) const noexcept;
 	const GchartMap::const_iterator begin (void) const noexcept;
 	const GchartMap::const_iterator last (void) const;
+	/* First sample at or after x. */
+	const GchartMap::const_iterator lowerBound (const float &x) const;
 	const GchartColor& getColor (void) const;
+	/* Add samples, for live data. Shared data (with the caller, other charts
+	 * or a render job) is copied first, after that they are added in place. */
+	void append (const GchartMap &samples);
+	/* Replace all samples, like with an answer of the source. */
+	void setSamples (const GchartMap &samples);
+	const std::shared_ptr<GchartDataSource>& getSource (void) const;
+	/* nullptr when the chart was not created from a series or its data changed since. */
+	const std::shared_ptr<const GchartSeries>& getSeries (void) const;
+	/* The x range of the data (of the source if there is one), NAN without data. */
+	float getXMin (void) const;
+	float getXMax (void) const;
 
+	/* The value at x. With it at map.end () x is found by binary search,
+	 * otherwise the walk continues from it and stops at the next sample when
+	 * that comes before x (x is changed to it). it is left at the sample
+	 * before x, or at map.end () outside of the chart. */
 	static float linear (const GchartMap &map, float &x, GchartMap::const_iterator &it);
 	static float curved2 (const GchartMap &map, float &x, GchartMap::const_iterator &it);
 	static float curved3 (const GchartMap &map, float &x, GchartMap::const_iterator &it);
@@ -0,0 +1,76 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartDataSource.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartDataSource.hpp"
+
+#include <cmath>
+#include <iterator>
+
+GchartDataSource::GchartDataSource (void) {
+	return;
+}
+
+GchartDataSource::~GchartDataSource (void) {
+	return;
+}
+
+GchartMap GchartDataSource::aggregate (const GchartMap &samples, const GchartDataRequest &request) {
+	GchartMap result;
+	if (request.columns <= 0 || !(request.x_max > request.x_min)) return samples;
+
+	const double scale = request.columns / static_cast<double>(request.x_max - request.x_min);
+	GchartMap::const_iterator first = samples.end (), min = samples.end (), max = samples.end ();
+	long column = 0;
+
+	auto flush = [&] (void) {
+		if (first == samples.end ()) return;
+		if (min->first < max->first) {
+			result.emplace_hint (result.end (), *min);
+			result.emplace_hint (result.end (), *max);
+		} else {
+			result.emplace_hint (result.end (), *max);
+			result.emplace_hint (result.end (), *min);
+		}
+	};
+
+	for (GchartMap::const_iterator it = samples.begin (); it != samples.end (); ++it) {
+		if (!std::isfinite (it->second)) {
+			/* Keep gaps. */
+			flush ();
+			first = samples.end ();
+			result.emplace_hint (result.end (), *it);
+			continue;
+		}
+		const long c = static_cast<long>(std::floor ((it->first - request.x_min) * scale));
+		if (first == samples.end () || c != column) {
+			flush ();
+			first = min = max = it;
+			column = c;
+		} else {
+			if (it->second < min->second) min = it;
+			if (it->second > max->second) max = it;
+		}
+	}
+	flush ();
+	return result;
+}
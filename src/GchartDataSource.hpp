@@ -0,0 +1,60 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartDataSource.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __GCHART_DATA_SOURCE_HPP__
+#define __GCHART_DATA_SOURCE_HPP__
+
+#include <functional>
+
+#include "GchartPoint.hpp"
+
+/* The part of a chart the widget needs: x_min up to x_max, drawn in columns pixel columns. */
+struct GchartDataRequest {
+	float x_min, x_max;
+	int columns;
+};
+
+/* Data of a chart that is not held in memory, see Gchart::addY1Source ().
+ * The widget only asks for what is visible and keeps only that. */
+class GchartDataSource {
+public:
+	/* Answer to a request, it may be called from any thread. */
+	typedef std::function<void(const GchartDataRequest &request, const GchartMap &samples)> Fulfil;
+
+	GchartDataSource (void);
+	virtual ~GchartDataSource (void);
+
+	/* The x range of all data, the widget zooms and pans within it. */
+	virtual float getXMin (void) const = 0;
+	virtual float getXMax (void) const = 0;
+	/* Call done with request and its samples, right away or later from any
+	 * thread. Include the sample before x_min and after x_max, so the line
+	 * reaches the border. For dense data the min and max per column are
+	 * enough, see aggregate (). It is called on a small thread pool of its
+	 * own (see GchartPrefetch), several requests can run at the same time.
+	 * A request that blocks keeps the other requests waiting, but not the
+	 * rendering. */
+	virtual void request (const GchartDataRequest &request, const Fulfil &done) = 0;
+
+	/* Reduce samples (in x order) to the min and max of every column of
+	 * request, in x order so the line keeps its shape. */
+	static GchartMap aggregate (const GchartMap &samples, const GchartDataRequest &request);
+};
+
+#endif /* __GCHART_DATA_SOURCE_HPP__ */
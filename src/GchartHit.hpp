@@ -0,0 +1,32 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartHit.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __GCHART_HIT_HPP__
+#define __GCHART_HIT_HPP__
+
+/* A sample found by Gchart::hitTest (). */
+struct GchartHit {
+	int identifier;
+	bool y2;            // the chart is on the y2 axis
+	float x, y;         // the sample, x is its key in the chart
+	double x_coord, y_coord; // where it is drawn in the buffer
+	double distance;    // from the pointer, in pixels
+};
+
+#endif /* __GCHART_HIT_HPP__ */
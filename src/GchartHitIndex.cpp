@@ -0,0 +1,148 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartHitIndex.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartHitIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <glib.h>
+
+#include "GchartRenderer.hpp"
+#include "GchartTrace.hpp"
+
+/* Width and height of a grid cell in pixels. */
+#define CELL_SIZE (16)
+
+GchartHitIndex::GchartHitIndex (const GchartViewport &v, const std::shared_ptr<GchartProvider> &y1, const std::shared_ptr<GchartProvider> &y2) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	GchartTraceScope trace ("render", "hitIndex");
+	std::vector<Entry> entries;
+
+	this->_columns = std::max (1, (v.width + CELL_SIZE - 1) / CELL_SIZE);
+	this->_rows = std::max (1, (v.height + CELL_SIZE - 1) / CELL_SIZE);
+	this->addProvider (v, y1, false, entries);
+	if (y2)
+		this->addProvider (v, y2, true, entries);
+
+	/* Counting sort by cell. */
+	this->_cells.assign (static_cast<std::size_t>(this->_columns) * this->_rows + 1, 0);
+	for (const Entry &e : entries)
+		this->_cells[this->getCell (e.x_coord, e.y_coord) + 1]++;
+	for (std::size_t i = 1; i < this->_cells.size (); ++i)
+		this->_cells[i] += this->_cells[i - 1];
+	std::vector<std::size_t> next (this->_cells.begin (), this->_cells.end () - 1);
+	this->_entries.resize (entries.size ());
+	for (const Entry &e : entries)
+		this->_entries[next[this->getCell (e.x_coord, e.y_coord)]++] = e;
+}
+
+GchartHitIndex::~GchartHitIndex (void) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+}
+
+void GchartHitIndex::addProvider (const GchartViewport &v, const std::shared_ptr<GchartProvider> &y, const bool &y2, std::vector<Entry> &entries) const {
+	/* The pixel rows used by the current chart in the current column. */
+	std::vector<bool> used (std::max (v.height, 1), false);
+	std::vector<int> used_rows;
+
+	for (const GchartChart &c : *(y.get ())) {
+		int column = -1;
+		for (GchartMap::const_iterator it = c.lowerBound (v.x_min); it != c.end () && (*it).first <= v.x_max; ++it) {
+			if (!std::isfinite ((*it).second)) continue;
+			const double x_coord = GchartRenderer::getXCoord (v, (*it).first);
+			const double y_coord = v.height - GchartRenderer::getYCoord (v, (*it).second, y);
+			if (!v.inPlotArea (x_coord, y_coord)) continue;
+
+			const int col = static_cast<int>(x_coord);
+			const int row = std::min (static_cast<int>(y_coord), v.height - 1);
+			if (col != column) {
+				for (const int &r : used_rows)
+					used[r] = false;
+				used_rows.clear ();
+				column = col;
+			}
+			if (used[row]) continue;
+			used[row] = true;
+			used_rows.push_back (row);
+			entries.push_back ({static_cast<float>(x_coord), static_cast<float>(y_coord), (*it).first, (*it).second, c.getIdentifier (), y2});
+		}
+		for (const int &r : used_rows)
+			used[r] = false;
+		used_rows.clear ();
+	}
+}
+
+int GchartHitIndex::getCell (const double &x_coord, const double &y_coord) const {
+	const int col = std::min (std::max (0, static_cast<int>(std::floor (x_coord / CELL_SIZE))), this->_columns - 1);
+	const int row = std::min (std::max (0, static_cast<int>(std::floor (y_coord / CELL_SIZE))), this->_rows - 1);
+	return row * this->_columns + col;
+}
+
+bool GchartHitIndex::find (const double &x_coord, const double &y_coord, const double &max_distance, GchartHit &hit) const {
+	g_debug("%s:%d %s (%f, %f, %f)", __FILE__, __LINE__, __func__, x_coord, y_coord, max_distance);
+	const Entry *best = nullptr;
+	double best_distance = max_distance;
+	const int cell_x = static_cast<int>(std::floor (x_coord / CELL_SIZE));
+	const int cell_y = static_cast<int>(std::floor (y_coord / CELL_SIZE));
+	const int max_ring = static_cast<int>(std::ceil (max_distance / CELL_SIZE));
+
+	/* Search rings of cells around the pointer, after ring r every sample
+	 * within r cells is seen, so a closer one can not follow. */
+	for (int r = 0; r <= max_ring; ++r) {
+		for (int dy = -r; dy <= r; ++dy) {
+			const int row = cell_y + dy;
+			if (row < 0 || row >= this->_rows) continue;
+			for (int dx = -r; dx <= r; ++dx) {
+				if (std::abs (dx) != r && std::abs (dy) != r) continue;
+				const int col = cell_x + dx;
+				if (col < 0 || col >= this->_columns) continue;
+
+				const std::size_t cell = static_cast<std::size_t>(row) * this->_columns + col;
+				for (std::size_t i = this->_cells[cell]; i < this->_cells[cell + 1]; ++i) {
+					const Entry &e = this->_entries[i];
+					const double distance = std::hypot (e.x_coord - x_coord, e.y_coord - y_coord);
+					if (distance <= best_distance) {
+						best_distance = distance;
+						best = &e;
+					}
+				}
+			}
+		}
+		if (best != nullptr && best_distance <= r * CELL_SIZE) break;
+	}
+	if (best == nullptr) return false;
+
+	hit.identifier = best->identifier;
+	hit.y2 = best->y2;
+	hit.x = best->x;
+	hit.y = best->y;
+	hit.x_coord = best->x_coord;
+	hit.y_coord = best->y_coord;
+	hit.distance = best_distance;
+	return true;
+}
+
+std::size_t GchartHitIndex::size (void) const noexcept {
+	return this->_entries.size ();
+}
@@ -0,0 +1,64 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartHitIndex.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __GCHART_HIT_INDEX_HPP__
+#define __GCHART_HIT_INDEX_HPP__
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "GchartChart.hpp"
+#include "GchartHit.hpp"
+#include "GchartProvider.hpp"
+#include "GchartViewport.hpp"
+
+/* The visible samples of a rendered buffer in a grid of screen cells, to
+ * find the sample nearest to the pointer without walking the charts. Of
+ * samples on the same pixel only the first is kept. It copies the samples it
+ * keeps, so the providers it was built from are not held on to (holding them
+ * would make every append to the charts copy them). */
+class GchartHitIndex {
+private:
+	struct Entry {
+		float x_coord, y_coord;
+		float x, y;
+		int identifier;
+		bool y2;
+	};
+
+	int _columns, _rows;
+	/* Sorted by cell, the entries of cell i are _entries[_cells[i]] up to _entries[_cells[i + 1]]. */
+	std::vector<Entry> _entries;
+	std::vector<std::size_t> _cells;
+
+	void addProvider (const GchartViewport &v, const std::shared_ptr<GchartProvider> &y, const bool &y2, std::vector<Entry> &entries) const;
+	int getCell (const double &x_coord, const double &y_coord) const;
+
+public:
+	/* v and the providers as they were rendered (see GchartRenderJob). */
+	GchartHitIndex (const GchartViewport &v, const std::shared_ptr<GchartProvider> &y1, const std::shared_ptr<GchartProvider> &y2);
+	~GchartHitIndex (void);
+
+	/* The sample nearest to x_coord, y_coord within max_distance pixels, false if there is none. */
+	bool find (const double &x_coord, const double &y_coord, const double &max_distance, GchartHit &hit) const;
+	std::size_t size (void) const noexcept;
+};
+
+#endif /* __GCHART_HIT_INDEX_HPP__ */
@@ -0,0 +1,94 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartInputTrace.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartInputTrace.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const char *event_names[] = {"motion", "scroll", "resize", "frame"};
+
+void GchartInputTrace::add (const EventType &type, const double &a, const double &b) {
+	this->_events.push_back ({type, a, b});
+}
+
+void GchartInputTrace::frame (const int &width, const int &height) {
+	if (width != this->_width || height != this->_height) {
+		this->_width = width;
+		this->_height = height;
+		this->add (RESIZE, width, height);
+	}
+	this->add (FRAME);
+}
+
+void GchartInputTrace::clear (void) {
+	this->_events.clear ();
+	this->_width = 0;
+	this->_height = 0;
+}
+
+const std::vector<GchartInputTrace::Event>& GchartInputTrace::getEvents (void) const {
+	return this->_events;
+}
+
+bool GchartInputTrace::save (const std::string &filename) const {
+	std::ofstream out (filename);
+	if (!out) return false;
+
+	out.precision (17);
+	out << "# gchart input trace\n";
+	for (const Event &e : this->_events) {
+		out << event_names[e.type];
+		if (e.type != FRAME)
+			out << ' ' << e.a << ' ' << e.b;
+		out << '\n';
+	}
+	return static_cast<bool>(out);
+}
+
+bool GchartInputTrace::load (const std::string &filename) {
+	std::ifstream in (filename);
+	std::string line;
+
+	if (!in) return false;
+	this->_events.clear ();
+	while (std::getline (in, line)) {
+		std::istringstream words (line);
+		std::string name;
+		Event e = {FRAME, 0, 0};
+		bool found = false;
+
+		if (!(words >> name) || name[0] == '#') continue;
+		for (int i = MOTION; i <= FRAME; ++i) {
+			if (name == event_names[i]) {
+				e.type = static_cast<EventType>(i);
+				found = true;
+			}
+		}
+		if (!found) return false;
+		if (e.type != FRAME && !(words >> e.a >> e.b)) return false;
+		this->_events.push_back (e);
+	}
+	return true;
+}
@@ -0,0 +1,60 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartInputTrace.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GCHART_INPUT_TRACE_HPP__
+#define __GCHART_INPUT_TRACE_HPP__
+
+#include <string>
+#include <vector>
+
+/* Input of a widget, grouped per frame, so it can be replayed offscreen.
+ * The file has one event per line: "motion x y", "scroll dx dy",
+ * "resize width height" or "frame". */
+class GchartInputTrace {
+public:
+	enum EventType {
+		MOTION = 0,
+		SCROLL,
+		RESIZE,
+		FRAME
+	};
+
+	struct Event {
+		EventType type;
+		double a, b;
+	};
+
+private:
+	std::vector<Event> _events;
+	int _width, _height;
+
+public:
+	GchartInputTrace (void) : _width (0), _height (0) {};
+	~GchartInputTrace (void) {};
+
+	void add (const EventType &type, const double &a = 0, const double &b = 0);
+	/* Mark the end of a frame, a RESIZE is added first when the size changed. */
+	void frame (const int &width, const int &height);
+	void clear (void);
+	const std::vector<Event>& getEvents (void) const;
+
+	bool save (const std::string &filename) const;
+	bool load (const std::string &filename);
+};
+
+#endif /* __GCHART_INPUT_TRACE_HPP__ */
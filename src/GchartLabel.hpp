@@ -19,10 +19,23 @@
 #ifndef __GCHART_LABEL_HPP__
 #define __GCHART_LABEL_HPP__
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
 
 #include "helper.hpp"
 
+/* Formatted values are kept per label, it is emptied when it gets this big. */
+#define LABEL_CACHE_SIZE (1024)
+
 class GchartLabel;
 
 typedef const std::string (*GchartValuePrint) (const GchartLabel *self, const float &value);
@@ -32,9 +45,27 @@ private:
 	const std::string _label;
 	const std::string _unit;
 	GchartValuePrint _unit_value_cb;
+	/* Labels are formatted from render threads while the owner may change
+	 * cacheable. Kept apart so a label can still be copied. */
+	struct Cache {
+		std::atomic<bool> cacheable;
+		std::unordered_map<float, std::string> texts;
+		std::mutex mutex;
+
+		Cache (const bool is_cacheable) : cacheable(is_cacheable) {};
+	};
+	std::unique_ptr<Cache> _cache;
+
+	/* Empty the texts of a full cache (traced, so it is not inline). */
+	static void clearTexts (Cache &cache);
 
 public:
-	GchartLabel (const std::string label, const std::string unit, GchartValuePrint unit_value_cb = &GchartLabel::defaultPrint) : _label(label), _unit(unit), _unit_value_cb(unit_value_cb) {};
+	/* Only the default printer is cached by default, a custom callback can opt in with cacheable
+	 * when it always returns the same text for the same value. */
+	GchartLabel (const std::string label, const std::string unit, GchartValuePrint unit_value_cb = &GchartLabel::defaultPrint) : _label(label), _unit(unit), _unit_value_cb(unit_value_cb), _cache(new Cache (unit_value_cb == &GchartLabel::defaultPrint)) {};
+	GchartLabel (const std::string label, const std::string unit, GchartValuePrint unit_value_cb, const bool cacheable) : _label(label), _unit(unit), _unit_value_cb(unit_value_cb), _cache(new Cache (cacheable)) {};
+	/* A copy starts with an empty cache. */
+	GchartLabel (const GchartLabel &other) : _label(other._label), _unit(other._unit), _unit_value_cb(other._unit_value_cb), _cache(new Cache (other.isCacheable ())) {};
 	~GchartLabel (void) {};
 
 	const std::string& getLabel (void) const {
@@ -45,11 +76,62 @@ public:
 		return this->_unit;
 	}
 
-	const std::string getValueUnitText (const float& value) const {
-		return this->_unit_value_cb (this, value);
+	/* Set use_cache to false for values that will hardly repeat, like the cursor read out. */
+	const std::string getValueUnitText (const float& value, const bool use_cache = true) const {
+		if (!use_cache || !this->isCacheable () || !std::isfinite (value))
+			return this->_unit_value_cb (this, value);
+
+		Cache &cache = *this->_cache;
+		{
+			std::lock_guard<std::mutex> lock (cache.mutex);
+			const auto it = cache.texts.find (value);
+			if (it != cache.texts.end ())
+				return it->second;
+		}
+
+		const std::string text = this->_unit_value_cb (this, value);
+		std::lock_guard<std::mutex> lock (cache.mutex);
+		if (cache.texts.size () >= LABEL_CACHE_SIZE)
+			GchartLabel::clearTexts (cache);
+		cache.texts.emplace (value, text);
+		return text;
+	}
+
+	void setCacheable (const bool cacheable) {
+		std::lock_guard<std::mutex> lock (this->_cache->mutex);
+		this->_cache->cacheable.store (cacheable, std::memory_order_relaxed);
+		this->_cache->texts.clear ();
+	}
+
+	bool isCacheable (void) const {
+		return this->_cache->cacheable.load (std::memory_order_relaxed);
+	}
+
+	/* Write the text of the default printer into buf, without allocating. Returns the length, or 0 if it does not fit. */
+	static std::size_t defaultFormat (const GchartLabel *self, const float &value, char *buf, const std::size_t &size) {
+		char *end = buf + size;
+		char *p;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+		const std::to_chars_result res = std::to_chars (buf, end, value, std::chars_format::fixed, 2);
+		if (res.ec != std::errc ()) return 0;
+		p = res.ptr;
+#else
+		const int n = std::snprintf (buf, size, "%0.2f", value);
+		if (n < 0 || static_cast<std::size_t>(n) >= size) return 0;
+		p = buf + n;
+#endif
+		const std::string &unit = self->getUnit ();
+		if (static_cast<std::size_t>(end - p) < unit.size () + 1) return 0;
+		*p++ = ' ';
+		p = std::copy (unit.begin (), unit.end (), p);
+		return p - buf;
 	}
 
 	static const std::string defaultPrint (const GchartLabel *self, const float &value) {
+		char buf[64];
+		const std::size_t n = GchartLabel::defaultFormat (self, value, buf, sizeof (buf));
+		if (n > 0)
+			return std::string (buf, n);
 		return string_format ("%0.2f %s", value, self->getUnit ().c_str());
 	}
 };
@@ -0,0 +1,208 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartPrefetch.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartPrefetch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <vector>
+#include <glib.h>
+#include <glibmm.h>
+
+#include "GchartThreadPool.hpp"
+#include "GchartTrace.hpp"
+
+/* Samples kept in the cache by default. */
+#define DEFAULT_MAX_SAMPLES (1 << 20)
+/* The predicted view is at most this much bigger or smaller than the current one. */
+#define MAX_ZOOM_STEP (4.0)
+/* Threads of getPool (). */
+#define SOURCE_THREADS (4)
+
+bool GchartPrefetch::Key::operator< (const Key &other) const {
+	return std::tie (this->y2, this->identifier, this->x_min, this->x_max, this->columns) < std::tie (other.y2, other.identifier, other.x_min, other.x_max, other.columns);
+}
+
+GchartPrefetch::GchartPrefetch (void) : _samples(0), _max_samples(DEFAULT_MAX_SAMPLES), _generation(1), _view({NAN, NAN, 0}), _pan(0), _zoom(1) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+}
+
+GchartPrefetch::~GchartPrefetch (void) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+}
+
+std::vector<GchartDataRequest> GchartPrefetch::getTiles (const GchartDataRequest &view) {
+	std::vector<GchartDataRequest> tiles;
+	const double span = view.x_max - view.x_min;
+	if (!(span > 0) || view.columns <= 0) return tiles;
+
+	const double width = std::ldexp (1.0, static_cast<int>(std::ceil (std::log2 (span))));
+	const double k_first = std::floor (view.x_min / width);
+	const double k_last = std::floor (view.x_max / width);
+	for (double k = k_first; k <= k_last; ++k)
+		tiles.push_back ({static_cast<float>(k * width), static_cast<float>((k + 1) * width), 2 * view.columns});
+	return tiles;
+}
+
+GchartThreadPool& GchartPrefetch::getPool (void) {
+	static GchartThreadPool pool (SOURCE_THREADS);
+	return pool;
+}
+
+bool GchartPrefetch::fetch (const bool &y2, const GchartChart &c, const GchartDataRequest &tile) {
+	const Key key = {y2, c.getIdentifier (), tile.x_min, tile.x_max, tile.columns};
+	if (this->_tiles.count (key) > 0) return true;
+	if (!this->_pending.insert (key).second) return false;
+
+	g_debug("%s:%d %s (%d, %d, %f, %f, %d)", __FILE__, __LINE__, __func__, y2, key.identifier, tile.x_min, tile.x_max, tile.columns);
+	const std::shared_ptr<GchartDataSource> source = c.getSource ();
+	const GchartDataSource::Fulfil done = this->_queue.createFulfil (y2, key.identifier, this->_generation);
+	GchartPrefetch::getPool ().push ([source, tile, done] () {
+		GchartTraceScope trace ("data", "sourceRequest");
+		source->request (tile, done);
+	});
+	return false;
+}
+
+bool GchartPrefetch::get (const bool &y2, const GchartChart &c, const GchartDataRequest &view, GchartMap &samples) {
+	std::vector<const Tile*> tiles;
+	bool complete = true;
+
+	for (const GchartDataRequest &tile : GchartPrefetch::getTiles (view)) {
+		if (!this->fetch (y2, c, tile)) {
+			complete = false;
+			continue;
+		}
+		Tile &t = this->_tiles[{y2, c.getIdentifier (), tile.x_min, tile.x_max, tile.columns}];
+		this->_lru.splice (this->_lru.begin (), this->_lru, t.lru);
+		tiles.push_back (&t);
+	}
+	if (complete) {
+		samples.clear ();
+		for (const Tile *t : tiles)
+			samples.insert (t->samples.begin (), t->samples.end ());
+	}
+	/* Only now, the tiles of the view are the most recently used. */
+	this->evict ();
+	return complete;
+}
+
+void GchartPrefetch::observe (const GchartDataRequest &view) {
+	const double span = view.x_max - view.x_min;
+	const double span_before = this->_view.x_max - this->_view.x_min;
+
+	if (span > 0 && span_before > 0 && view.columns == this->_view.columns) {
+		this->_pan = ((view.x_min + view.x_max) - (this->_view.x_min + this->_view.x_max)) / 2 / span;
+		this->_zoom = span / span_before;
+	} else {
+		this->_pan = 0;
+		this->_zoom = 1;
+	}
+	this->_view = view;
+}
+
+void GchartPrefetch::requestAhead (const std::shared_ptr<GchartProvider> &y1, const std::shared_ptr<GchartProvider> &y2) {
+	g_debug("%s:%d %s (%f, %f)", __FILE__, __LINE__, __func__, this->_pan, this->_zoom);
+	const GchartDataRequest &v = this->_view;
+	const double span = v.x_max - v.x_min;
+	if (!(span > 0)) return;
+
+	/* The next view if the speed stays the same, and the views left and right of the current one. */
+	const double zoom = std::min (MAX_ZOOM_STEP, std::max (1 / MAX_ZOOM_STEP, this->_zoom));
+	const double center = (v.x_min + v.x_max) / 2.0 + this->_pan * span;
+	std::vector<GchartDataRequest> views = {
+		{static_cast<float>(center - span * zoom / 2), static_cast<float>(center + span * zoom / 2), v.columns},
+		{static_cast<float>(v.x_min - span), v.x_min, v.columns},
+		{v.x_max, static_cast<float>(v.x_max + span), v.columns}
+	};
+
+	for (int axis = 0; axis < 2; ++axis) {
+		const std::shared_ptr<GchartProvider> &y = (axis == 0) ? y1 : y2;
+		if (!y) continue;
+		for (const GchartChart &c : *(y.get ())) {
+			if (!c.getSource ()) continue;
+			for (const GchartDataRequest &view : views) {
+				for (const GchartDataRequest &tile : GchartPrefetch::getTiles (view))
+					this->fetch (axis == 1, c, tile);
+			}
+		}
+	}
+}
+
+bool GchartPrefetch::takeResults (void) {
+	bool added = false;
+	const std::vector<GchartDataRequest> view_tiles = GchartPrefetch::getTiles (this->_view);
+
+	for (const GchartSourceQueue::Result &r : this->_queue.takeResults ()) {
+		const Key key = {r.y2, r.identifier, r.request.x_min, r.request.x_max, r.request.columns};
+		if (r.serial != this->_generation) continue;
+		this->_pending.erase (key);
+		if (this->_tiles.count (key) > 0) continue;
+
+		/* Tiles of the current view are needed next, the others (requested
+		 * ahead) are the least likely to be needed and are dropped first. */
+		const bool in_view = std::any_of (view_tiles.begin (), view_tiles.end (), [&key] (const GchartDataRequest &tile) {
+			return tile.x_min == key.x_min && tile.x_max == key.x_max && tile.columns == key.columns;
+		});
+		Tile &t = this->_tiles[key];
+		t.samples = r.samples;
+		t.lru = this->_lru.insert (in_view ? this->_lru.begin () : this->_lru.end (), key);
+		this->_samples += t.samples.size ();
+		added = true;
+	}
+	/* Without this the cache grows until the next get (). */
+	this->evict ();
+	return added;
+}
+
+void GchartPrefetch::evict (void) {
+	while (this->_samples > this->_max_samples && this->_lru.size () > 1) {
+		const auto it = this->_tiles.find (this->_lru.back ());
+		this->_samples -= it->second.samples.size ();
+		this->_tiles.erase (it);
+		this->_lru.pop_back ();
+	}
+}
+
+void GchartPrefetch::setMaxSamples (const std::size_t &max_samples) {
+	this->_max_samples = max_samples;
+	this->evict ();
+}
+
+void GchartPrefetch::clear (void) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	this->_tiles.clear ();
+	this->_lru.clear ();
+	this->_pending.clear ();
+	this->_samples = 0;
+	this->_generation++;
+}
+
+Glib::Dispatcher& GchartPrefetch::signal_ready (void) {
+	return this->_queue.signal_ready ();
+}
@@ -0,0 +1,100 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartPrefetch.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __GCHART_PREFETCH_HPP__
+#define __GCHART_PREFETCH_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+#include <glibmm.h>
+
+#include "GchartChart.hpp"
+#include "GchartDataSource.hpp"
+#include "GchartProvider.hpp"
+#include "GchartSourceQueue.hpp"
+#include "GchartThreadPool.hpp"
+
+/* Cache of GchartDataSource data in tiles, for Gchart. A view of span s is
+ * covered by the tiles of width 2^ceil(log2(s)) (one or two of them), each
+ * with twice the columns of the view. Tiles are requested on getPool (),
+ * also the ones next to the view and of the view the pan and zoom speed
+ * predict, so they are there before they are shown. The least recently
+ * used tiles are dropped beyond max_samples. */
+class GchartPrefetch {
+private:
+	struct Key {
+		bool y2;
+		int identifier;
+		float x_min, x_max;
+		int columns;
+
+		bool operator< (const Key &other) const;
+	};
+	struct Tile {
+		GchartMap samples;
+		std::list<Key>::iterator lru;
+	};
+
+	std::map<Key, Tile> _tiles;
+	/* Most recently used first. */
+	std::list<Key> _lru;
+	std::set<Key> _pending;
+	std::size_t _samples, _max_samples;
+	/* Answers to requests from before clear () are dropped. */
+	uint64_t _generation;
+	GchartSourceQueue _queue;
+	/* The last view and the change to it: shift of the centre in spans and span ratio. */
+	GchartDataRequest _view;
+	double _pan, _zoom;
+
+	static std::vector<GchartDataRequest> getTiles (const GchartDataRequest &view);
+	/* Sources may block on I/O, so they get their own few threads (shared by
+	 * all widgets) and never hold up the render tasks on GchartThreadPool::getDefault (). */
+	static GchartThreadPool& getPool (void);
+	/* Request a tile that is not cached or pending, returns true if it is cached. */
+	bool fetch (const bool &y2, const GchartChart &c, const GchartDataRequest &tile);
+	void evict (void);
+
+public:
+	GchartPrefetch (void);
+	~GchartPrefetch (void);
+
+	/* The samples of view from the cache, if all its tiles are there. The
+	 * missing tiles are requested. */
+	bool get (const bool &y2, const GchartChart &c, const GchartDataRequest &view, GchartMap &samples);
+	/* Remember a new view, for the pan and zoom speed. */
+	void observe (const GchartDataRequest &view);
+	/* Request the tiles of the views around the last observed one, for all
+	 * charts with a source. */
+	void requestAhead (const std::shared_ptr<GchartProvider> &y1, const std::shared_ptr<GchartProvider> &y2);
+	/* Move the answers into the cache, only from the main loop. Returns true
+	 * if new tiles came in. */
+	bool takeResults (void);
+	void setMaxSamples (const std::size_t &max_samples);
+	void clear (void);
+	/* Emitted in the main loop when answers come in, see takeResults (). */
+	Glib::Dispatcher& signal_ready (void);
+};
+
+#endif /* __GCHART_PREFETCH_HPP__ */
@@ -22,51 +22,127 @@
 
 #include "GchartProvider.hpp"
 
+#include <atomic>
 #include <cmath>
 #include <memory>
 #include <string>
-#include <forward_list>
+#include <list>
+#include <unordered_map>
 #include <stdexcept>
 
 #include "GchartColor.hpp"
 #include "GchartPoint.hpp"
 #include "GchartLabel.hpp"
 #include "GchartChart.hpp"
+#include "GchartTrace.hpp"
+
+static uint64_t nextRevision (void) {
+	static std::atomic<uint64_t> revision (0);
+	return ++revision;
+}
 
 GchartProvider::GchartProvider (const std::string &label, const std::string &unit, GchartValuePrint print) {
+	this->_revision = nextRevision ();
 	this->_label = std::make_shared<GchartLabel> (label, unit, print);
 	this->_y_min = NAN;
 	this->_y_max = NAN;
 	this->_y_scale = 1.0;
 }
 
+GchartProvider::GchartProvider (const GchartProvider &other) : _y_min(other._y_min), _y_max(other._y_max), _y_scale(other._y_scale), _revision(other._revision), _label(other._label), _charts(other._charts) {
+	this->_index.reserve (this->_charts.size ());
+	for (auto it = this->_charts.begin (); it != this->_charts.end (); ++it)
+		this->_index.emplace (it->getIdentifier (), it);
+}
+
 GchartProvider::~GchartProvider (void) {
 	return;
 }
 
 bool GchartProvider::addChart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const GchartMap chart, GchartGetValue get_value) {
+	return this->addChart (t, identifier, color, std::make_shared<const GchartMap> (chart), get_value);
+}
+
+bool GchartProvider::addChart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const std::shared_ptr<const GchartMap> &chart, GchartGetValue get_value) {
+	GchartTraceScope trace ("data", "addChart");
+	if (this->_index.count (identifier) > 0)
+		return false;
+	this->_revision = nextRevision ();
 	this->_charts.emplace_front (t, identifier, color, chart, get_value);
-	if (this->_charts.front ().getIdentifier () == identifier)
-		return true;
-	return false;
+	this->_index.emplace (identifier, this->_charts.begin ());
+	return true;
+}
+
+bool GchartProvider::addChart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const std::shared_ptr<const GchartSeries> &series, GchartGetValue get_value) {
+	GchartTraceScope trace ("data", "addChart");
+	if (this->_index.count (identifier) > 0)
+		return false;
+	this->_revision = nextRevision ();
+	this->_charts.emplace_front (t, identifier, color, series, get_value);
+	this->_index.emplace (identifier, this->_charts.begin ());
+	return true;
+}
+
+bool GchartProvider::addSource (const int &identifier, const GchartColor &color, const std::shared_ptr<GchartDataSource> &source) {
+	GchartTraceScope trace ("data", "addSource");
+	if (this->_index.count (identifier) > 0)
+		return false;
+	this->_revision = nextRevision ();
+	this->_charts.emplace_front (identifier, color, source);
+	this->_index.emplace (identifier, this->_charts.begin ());
+	return true;
+}
+
+bool GchartProvider::appendSamples (const int &identifier, const GchartMap &samples) {
+	GchartTraceScope trace ("data", "appendSamples");
+	const auto it = this->_index.find (identifier);
+	if (it == this->_index.end ())
+		return false;
+
+	GchartChart &c = *it->second;
+	/* Samples before the end change what is already drawn. */
+	if (!samples.empty () && c.size () > 0 && samples.begin ()->first <= c.last ()->first)
+		this->_revision = nextRevision ();
+	c.append (samples);
+	return true;
+}
+
+bool GchartProvider::setSamples (const int &identifier, const GchartMap &samples) {
+	GchartTraceScope trace ("data", "setSamples");
+	const auto it = this->_index.find (identifier);
+	if (it == this->_index.end ())
+		return false;
+
+	this->_revision = nextRevision ();
+	it->second->setSamples (samples);
+	return true;
 }
 
 bool GchartProvider::removeChart (const int &identifier) {
-	for (auto it = this->_charts.before_begin (); it != this->_charts.end (); ++it) {
-		const auto it_next = std::next (it, 1);
-		if (it_next == this->_charts.end ()) break;
-		if (identifier == (*it_next).getIdentifier ())
-		{
-			this->_charts.erase_after (it);
-			return true;
-		}
-	}
-	return false;
+	GchartTraceScope trace ("data", "removeChart");
+	const auto it = this->_index.find (identifier);
+	if (it == this->_index.end ())
+		return false;
+
+	this->_revision = nextRevision ();
+	this->_charts.erase (it->second);
+	this->_index.erase (it);
+	return true;
 }
 
 float GchartProvider::getYMax (void) const {
+	GchartTraceScope trace ("data", "getYMax");
 	float y_max = NAN;
 	for (const auto &chart : this->_charts) {
+		if (chart.getSeries ()) {
+			/* Derived once for everybody who shows the series. */
+			const float value = chart.getSeries ()->getYMax ();
+			if (!std::isfinite (y_max))
+				y_max = value;
+			else if (std::isfinite (value))
+				y_max = std::max (value, y_max);
+			continue;
+		}
 		for (const auto &v : chart) {
 			if (!std::isfinite (y_max))
 				y_max = v.second;
@@ -78,23 +154,42 @@ float GchartProvider::getYMax (void) const {
 }
 
 float GchartProvider::getYMax (const float &x_min, const float &x_max) const {
+	GchartTraceScope trace ("data", "getYMax");
 	float y_max = NAN;
 	for (const auto &chart : this->_charts) {
-		for (const auto &v : chart) {
-			if (v.first >= x_min && v.first <= x_max) {
-				if (!std::isfinite (y_max))
-					y_max = v.second;
-				else
-					y_max = std::max (v.second, y_max);
-			}
+		if (chart.getSeries () && chart.size () > 0 && x_min <= chart.begin ()->first && x_max >= chart.last ()->first) {
+			/* The whole series is in the range. */
+			const float value = chart.getSeries ()->getYMax ();
+			if (!std::isfinite (y_max))
+				y_max = value;
+			else if (std::isfinite (value))
+				y_max = std::max (value, y_max);
+			continue;
+		}
+		/* Only the samples in the range, found by binary search. */
+		for (auto it = chart.lowerBound (x_min); it != chart.end () && (*it).first <= x_max; ++it) {
+			if (!std::isfinite (y_max))
+				y_max = (*it).second;
+			else
+				y_max = std::max ((*it).second, y_max);
 		}
 	}
 	return y_max;
 }
 
 float GchartProvider::getYMin (void) const {
+	GchartTraceScope trace ("data", "getYMin");
 	float y_min = NAN;
 	for (const auto &chart : this->_charts) {
+		if (chart.getSeries ()) {
+			/* Derived once for everybody who shows the series. */
+			const float value = chart.getSeries ()->getYMin ();
+			if (!std::isfinite (y_min))
+				y_min = value;
+			else if (std::isfinite (value))
+				y_min = std::min (value, y_min);
+			continue;
+		}
 		for (const auto &v : chart) {
 			if (!std::isfinite (y_min))
 				y_min = v.second;
@@ -106,15 +201,24 @@ float GchartProvider::getYMin (void) const {
 }
 
 float GchartProvider::getYMin (const float &x_min, const float &x_max) const {
+	GchartTraceScope trace ("data", "getYMin");
 	float y_min = NAN;
 	for (const auto &chart : this->_charts) {
-		for (const auto &v : chart) {
-			if (v.first >= x_min && v.first <= x_max) {
-				if (!std::isfinite (y_min))
-					y_min = v.second;
-				else
-					y_min = std::min (v.second, y_min);
-			}
+		if (chart.getSeries () && chart.size () > 0 && x_min <= chart.begin ()->first && x_max >= chart.last ()->first) {
+			/* The whole series is in the range. */
+			const float value = chart.getSeries ()->getYMin ();
+			if (!std::isfinite (y_min))
+				y_min = value;
+			else if (std::isfinite (value))
+				y_min = std::min (value, y_min);
+			continue;
+		}
+		/* Only the samples in the range, found by binary search. */
+		for (auto it = chart.lowerBound (x_min); it != chart.end () && (*it).first <= x_max; ++it) {
+			if (!std::isfinite (y_min))
+				y_min = (*it).second;
+			else
+				y_min = std::min ((*it).second, y_min);
 		}
 	}
 	return y_min;
@@ -124,9 +228,9 @@ float GchartProvider::getXMax (void) const {
 	float x_max = NAN;
 	for (const auto &chart : this->_charts) {
 		if (!std::isfinite (x_max))
-			x_max = chart.last ()->first;
-		else
-			x_max = std::max (chart.last ()->first, x_max);
+			x_max = chart.getXMax ();
+		else if (std::isfinite (chart.getXMax ()))
+			x_max = std::max (chart.getXMax (), x_max);
 	}
 	return x_max;
 }
@@ -135,9 +239,9 @@ float GchartProvider::getXMin (void) const {
 	float x_min = NAN;
 	for (const auto &c : this->_charts) {
 		if (!std::isfinite (x_min))
-			x_min = c.begin ()->first;
-		else
-			x_min = std::min (c.begin ()->first, x_min);
+			x_min = c.getXMin ();
+		else if (std::isfinite (c.getXMin ()))
+			x_min = std::min (c.getXMin (), x_min);
 	}
 	return x_min;
 }
@@ -147,30 +251,32 @@ const std::shared_ptr<GchartLabel>& GchartProvider::getLabel (void) const {
 }
 
 const GchartChart& GchartProvider::operator[] (const int &identifier) const {
-	for (const GchartChart &c : this->_charts) {
-		if (identifier == c.getIdentifier ())
-			return c;
-	}
-	throw std::range_error ("Value is not present in list.");
+	const auto it = this->_index.find (identifier);
+	if (it == this->_index.end ())
+		throw std::range_error ("Value is not present in list.");
+	return *it->second;
 }
 
-std::forward_list<GchartChart>::const_iterator GchartProvider::end (void) const noexcept {
+GchartProvider::const_iterator GchartProvider::end (void) const noexcept {
 	return this->_charts.end ();
 }
 
-std::forward_list<GchartChart>::const_iterator GchartProvider::begin (void) const noexcept {
+GchartProvider::const_iterator GchartProvider::begin (void) const noexcept {
 	return this->_charts.begin ();
 }
 
 std::size_t GchartProvider::size (void) const noexcept {
-	return std::distance (this->_charts.begin (), this->_charts.end ());
+	return this->_charts.size ();
 }
 
 void GchartProvider::reset (bool confirm) {
 	if (confirm) {
+		GchartTraceScope trace ("data", "reset");
 		this->_y_min = NAN;
 		this->_y_max = NAN;
 		this->_y_scale = 1.0;
+		this->_revision = nextRevision ();
 		this->_charts.clear ();
+		this->_index.clear ();
 	}
 }
@@ -19,10 +19,12 @@
 #ifndef __GCHART_PROVIDER_HPP__
 #define __GCHART_PROVIDER_HPP__
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <iterator>
-#include <forward_list>
+#include <list>
+#include <unordered_map>
 
 #include "GchartColor.hpp"
 #include "GchartPoint.hpp"
@@ -30,21 +32,41 @@
 #include "GchartChart.hpp"
 
 class GchartProvider {
-private:
-	typedef GchartChart* iterator;
-	typedef const GchartChart* const_iterator;
+public:
+	typedef std::list<GchartChart>::const_iterator const_iterator;
 
+private:
 	float _y_min, _y_max, _y_scale;
+	/* Changes when charts are added or removed or old data changes, so a
+	 * renderer can tell if an earlier buffer still shows the same charts. */
+	uint64_t _revision;
 	std::shared_ptr<GchartLabel> _label;
-	std::forward_list<GchartChart> _charts;
-
-	bool addChart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const GchartMap chart, GchartGetValue get_value);
+	/* The charts in drawing order, the index finds them by identifier. */
+	std::list<GchartChart> _charts;
+	std::unordered_map<int, std::list<GchartChart>::iterator> _index;
 
 public:
 	GchartProvider (const std::string &label, const std::string &unit, GchartValuePrint print);
+	/* Copies share the chart data, the index is rebuilt. */
+	GchartProvider (const GchartProvider &other);
+	GchartProvider& operator= (const GchartProvider &other) = delete;
 	~GchartProvider (void);
 
+	/* An identifier can only be used once, adding it again fails. */
+	bool addChart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const GchartMap chart, GchartGetValue get_value);
+	/* The data is shared and not copied, it must not be changed afterwards. */
+	bool addChart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const std::shared_ptr<const GchartMap> &chart, GchartGetValue get_value);
+	/* The series is shared, also its derived values, see GchartSeries. */
+	bool addChart (const GchartChart::Type &t, const int &identifier, const GchartColor &color, const std::shared_ptr<const GchartSeries> &series, GchartGetValue get_value);
+
+	/* A chart of the data of source, see GchartDataSource. */
+	bool addSource (const int &identifier, const GchartColor &color, const std::shared_ptr<GchartDataSource> &source);
+
 	bool removeChart (const int &identifier);
+	/* Add samples to a chart, see GchartChart::append (). */
+	bool appendSamples (const int &identifier, const GchartMap &samples);
+	/* Replace the samples of a chart, see GchartChart::setSamples (). */
+	bool setSamples (const int &identifier, const GchartMap &samples);
 	/* If charts is changed, call this->drawing->reload(); */
 	float getYMax () const;
 	float getYMax (const float &x_min, const float &x_max) const;
@@ -54,12 +76,13 @@ public:
 	float getXMin () const;
 	const std::shared_ptr<GchartLabel>& getLabel (void) const;
 	const GchartChart& operator[] (const int &identifier) const;
-	std::forward_list<GchartChart>::const_iterator end (void) const noexcept;
-	std::forward_list<GchartChart>::const_iterator begin (void) const noexcept;
+	const_iterator end (void) const noexcept;
+	const_iterator begin (void) const noexcept;
 	std::size_t size (void) const noexcept;
 	void reset (bool confirm = false);
 
-	friend class Gchart;
+	friend class GchartRenderer;
+	friend class GchartAutoscale;
 };
 
 #endif /* __GCHART_PROVIDER_HPP__ */
@@ -0,0 +1,113 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartRenderThread.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartRenderThread.hpp"
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <glibmm.h>
+
+GchartRenderThread::GchartRenderThread (RenderFunc render) : _render(render), _quit(false) {
+	return;
+}
+
+GchartRenderThread::~GchartRenderThread (void) {
+	{
+		std::lock_guard<std::mutex> lock (this->_mutex);
+		this->_quit = true;
+		if (this->_pending) this->_pending->cancelled = true;
+		if (this->_running) this->_running->cancelled = true;
+	}
+	this->_cond.notify_all ();
+	if (this->_thread.joinable ())
+		this->_thread.join ();
+}
+
+void GchartRenderThread::submit (const std::shared_ptr<GchartRenderJob> &job) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	{
+		std::lock_guard<std::mutex> lock (this->_mutex);
+		if (this->_pending) this->_pending->cancelled = true;
+		if (this->_running) this->_running->cancelled = true;
+		this->_pending = job;
+		this->_result.reset ();
+		/* Only start the thread when it is needed. */
+		if (!this->_thread.joinable ())
+			this->_thread = std::thread (&GchartRenderThread::run, this);
+	}
+	this->_cond.notify_all ();
+}
+
+void GchartRenderThread::cancel (void) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	std::unique_lock<std::mutex> lock (this->_mutex);
+	if (this->_pending) this->_pending->cancelled = true;
+	this->_pending.reset ();
+	this->_result.reset ();
+	if (this->_running) this->_running->cancelled = true;
+	this->_cond.wait (lock, [this] { return !this->_running; });
+}
+
+bool GchartRenderThread::isBusy (void) {
+	std::lock_guard<std::mutex> lock (this->_mutex);
+	return (this->_pending || this->_running);
+}
+
+std::shared_ptr<GchartRenderJob> GchartRenderThread::takeResult (void) {
+	std::lock_guard<std::mutex> lock (this->_mutex);
+	std::shared_ptr<GchartRenderJob> job = std::move (this->_result);
+	this->_result.reset ();
+	return job;
+}
+
+Glib::Dispatcher& GchartRenderThread::signal_done (void) {
+	return this->_done;
+}
+
+void GchartRenderThread::run (void) {
+	std::unique_lock<std::mutex> lock (this->_mutex);
+	while (true) {
+		this->_cond.wait (lock, [this] { return this->_quit || this->_pending; });
+		if (this->_quit) break;
+
+		this->_running = std::move (this->_pending);
+		this->_pending.reset ();
+		std::shared_ptr<GchartRenderJob> job = this->_running;
+		lock.unlock ();
+
+		this->_render (*job);
+
+		lock.lock ();
+		this->_running.reset ();
+		bool finished = !job->isCancelled ();
+		if (finished)
+			this->_result = job;
+		/* Wake up cancel () */
+		this->_cond.notify_all ();
+		if (finished) {
+			lock.unlock ();
+			this->_done.emit ();
+			lock.lock ();
+		}
+	}
+}
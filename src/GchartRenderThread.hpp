@@ -0,0 +1,64 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartRenderThread.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GCHART_RENDER_THREAD_HPP__
+#define __GCHART_RENDER_THREAD_HPP__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include <glibmm.h>
+#include <cairomm/cairomm.h>
+
+#include "GchartRenderer.hpp"
+
+class GchartRenderThread {
+public:
+	typedef std::function<void(GchartRenderJob&)> RenderFunc;
+
+private:
+	RenderFunc _render;
+	std::thread _thread;
+	std::mutex _mutex;
+	std::condition_variable _cond;
+	std::shared_ptr<GchartRenderJob> _pending, _running, _result;
+	bool _quit;
+	Glib::Dispatcher _done;
+
+	void run (void);
+
+public:
+	GchartRenderThread (RenderFunc render);
+	~GchartRenderThread (void);
+
+	/* Queue a job, the job that is in flight (if any) is cancelled. */
+	void submit (const std::shared_ptr<GchartRenderJob> &job);
+	/* Cancel all work and wait until the worker does not touch any job data anymore. */
+	void cancel (void);
+	/* A job is queued or running. */
+	bool isBusy (void);
+	/* Get the last finished job, only call this from the main loop. */
+	std::shared_ptr<GchartRenderJob> takeResult (void);
+	/* Emitted in the main loop when a job is finished. */
+	Glib::Dispatcher& signal_done (void);
+};
+
+#endif /* __GCHART_RENDER_THREAD_HPP__ */
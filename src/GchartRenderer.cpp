@@ -0,0 +1,1346 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartRenderer.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartRenderer.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include <glib.h>
+#include <cairomm/cairomm.h>
+
+#include "GchartProvider.hpp"
+#include "GchartHitIndex.hpp"
+#include "GchartThreadPool.hpp"
+#include "GchartTextCache.hpp"
+#include "GchartTrace.hpp"
+
+#define PADDING (5)
+#define BORDER_OFFSET (PADDING)
+#define DOT_RADIUS 2.0
+/* Grid steps are one of these times a power of ten. */
+static const double TICK_MULTIPLES[] = {1.0, 2.0, 5.0};
+
+#if _ENABLE_GTK == 4
+#define LINECAP_ROUND ROUND
+#define LINECAP_BUTT BUTT
+#define LINEJOIN_ROUND ROUND
+#define LINEJOIN_MITER MITER
+#define ARGB32 ARGB32
+#elif _ENABLE_GTK == 3
+#define LINECAP_ROUND LINE_CAP_ROUND
+#define LINECAP_BUTT LINE_CAP_BUTT
+#define LINEJOIN_ROUND LINE_JOIN_ROUND
+#define LINEJOIN_MITER LINE_JOIN_MITER
+#define ARGB32 FORMAT_ARGB32
+#endif
+
+GchartRenderer::GchartRenderer (const std::shared_ptr<GchartLabel> &label, const std::shared_ptr<GchartProvider> &y1, const std::shared_ptr<GchartProvider> &y2) : _label(label), _y1(y1), _y2(y2), _tiles(1), _y1_autoscale(std::make_shared<GchartAutoscale> ()), _y2_autoscale(std::make_shared<GchartAutoscale> ()) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+}
+
+GchartRenderer::~GchartRenderer (void) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+}
+
+GchartViewport& GchartRenderer::getViewport (void) {
+	return this->_viewport;
+}
+
+void GchartRenderer::setTiles (const unsigned int &tiles) {
+	this->_tiles = std::max (1u, tiles);
+}
+
+const GchartStats& GchartRenderer::getStats (void) const {
+	return this->_stats;
+}
+
+void GchartRenderer::render (const Cairo::RefPtr<Cairo::Surface> &surface, const int &width, const int &height) {
+	this->render (surface, width, height, false, 0);
+}
+
+void GchartRenderer::renderVector (const Cairo::RefPtr<Cairo::Surface> &surface, const int &width, const int &height, const double &tolerance) {
+	this->render (surface, width, height, true, tolerance);
+}
+
+bool GchartRenderer::exportSvg (const std::string &filename, const int &width, const int &height, const double &tolerance) {
+	g_debug("%s:%d %s (%s, %d, %d, %f)", __FILE__, __LINE__, __func__, filename.c_str (), width, height, tolerance);
+#ifdef CAIRO_HAS_SVG_SURFACE
+	try {
+		auto surface = Cairo::SvgSurface::create (filename, width, height);
+		this->renderVector (surface, width, height, tolerance);
+		surface->finish ();
+		return true;
+	} catch (const std::exception &e) {
+		g_warning ("Can not write %s: %s", filename.c_str (), e.what ());
+	}
+#endif
+	return false;
+}
+
+bool GchartRenderer::exportPdf (const std::string &filename, const int &width, const int &height, const double &tolerance) {
+	g_debug("%s:%d %s (%s, %d, %d, %f)", __FILE__, __LINE__, __func__, filename.c_str (), width, height, tolerance);
+#ifdef CAIRO_HAS_PDF_SURFACE
+	try {
+		auto surface = Cairo::PdfSurface::create (filename, width, height);
+		this->renderVector (surface, width, height, tolerance);
+		surface->finish ();
+		return true;
+	} catch (const std::exception &e) {
+		g_warning ("Can not write %s: %s", filename.c_str (), e.what ());
+	}
+#endif
+	return false;
+}
+
+void GchartRenderer::render (const Cairo::RefPtr<Cairo::Surface> &surface, const int &width, const int &height, const bool &vector, const double &tolerance) {
+	g_debug("%s:%d %s (-, %d, %d)", __FILE__, __LINE__, __func__, width, height);
+	GchartRenderJob job;
+
+	job.viewport = this->_viewport;
+	job.viewport.width = width;
+	job.viewport.height = height;
+	job.label = this->_label;
+	/* The y ranges are stored in the providers, keep the ones of the caller untouched. */
+	job.y1 = std::make_shared<GchartProvider> (*this->_y1);
+	if (this->_y2)
+		job.y2 = std::make_shared<GchartProvider> (*this->_y2);
+	job.surface = surface;
+	job.tiles = this->_tiles;
+	job.y1_autoscale = this->_y1_autoscale;
+	job.y2_autoscale = this->_y2_autoscale;
+	job.vector = vector;
+	job.tolerance = tolerance;
+
+	GchartRenderer::drawBuffer (job);
+	this->_viewport = job.viewport;
+	this->_stats = job.stats;
+}
+
+Cairo::RefPtr<Cairo::ImageSurface> GchartRenderer::render (const int &width, const int &height) {
+	auto surface = GchartRenderer::createImageSurface (width, height);
+	this->render (surface, width, height);
+	return surface;
+}
+
+Cairo::RefPtr<Cairo::ImageSurface> GchartRenderer::createImageSurface (const int &width, const int &height, const int &scale) {
+	auto surface = Cairo::ImageSurface::create (CAIRO_ENUM_NS_SURFACE::Format::ARGB32, width * scale, height * scale);
+	if (scale != 1)
+		cairo_surface_set_device_scale (surface->cobj (), scale, scale);
+	return surface;
+}
+
+void GchartRenderer::renderInfo (const Cairo::RefPtr<Cairo::Context>& layer, const float &x_info_value) const {
+	GchartRenderer::drawInfo (layer, this->_viewport, this->_label, this->_y1, this->_y2, x_info_value);
+}
+
+void GchartRenderer::calulateOffsets (GchartRenderJob &job) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	GchartViewport &v = job.viewport;
+
+	/* Get expected text width for the top and left. This is based on the labels on the y-axis */
+	Cairo::TextExtents extents, extents2;
+	std::string text;
+	float info_box_width;
+
+	GchartTextCache &cache = GchartTextCache::getDefault ();
+	auto layer = GchartTextCache::createMeasureContext ();
+
+	text = job.y1->getLabel ()->getValueUnitText (0.0);
+	cache.getTextExtents (layer, text, extents);
+	text.clear();
+	extents.width += PADDING;
+	extents.height += PADDING;
+	v.offset_left = extents.width + BORDER_OFFSET;
+	v.offset_top = extents.height / 2 + BORDER_OFFSET;
+	info_box_width = extents.width;
+
+	/* Get expected text width for the info box */
+	cache.getTextExtents (layer, job.label->getLabel (), extents);
+	extents.width += PADDING;
+	info_box_width = MAX(extents.width, info_box_width);
+
+	cache.getTextExtents (layer, job.y1->getLabel ()->getLabel (), extents);
+	extents.width += PADDING;
+	info_box_width = MAX(extents.width, info_box_width);
+
+	if(job.y2) {
+		cache.getTextExtents (layer, job.y2->getLabel ()->getLabel (), extents);
+		extents.width += PADDING;
+		info_box_width = MAX(extents.width, info_box_width);
+	}
+
+	/* Get expected text width for bottom and right. This is based on the labels on the x-axis */
+	text = job.label->getValueUnitText (0.0);
+
+	cache.getTextExtents (layer, text, extents);
+	text.clear ();
+	if(job.y2) {
+		text = job.y2->getLabel ()->getValueUnitText (0.0);
+		cache.getTextExtents (layer, text, extents2);
+		text.clear ();
+		extents2.width += PADDING;
+		info_box_width = MAX(extents2.width, info_box_width);
+	} else
+		extents2.width = 0;
+	extents.width += PADDING;
+	extents.height += PADDING;
+	info_box_width = MAX(extents.width, info_box_width);
+	v.offset_bottom = extents.height + BORDER_OFFSET;
+	v.infobox_width = info_box_width + 10 * BORDER_OFFSET;
+	v.offset_right = extents.width / 2 + extents2.width + v.infobox_width + BORDER_OFFSET;
+}
+
+void GchartRenderer::drawCursor (const Cairo::RefPtr<Cairo::Context>& layer, const GchartViewport &v, const float &x_value) {
+	g_debug("%s:%d %s (-, -, %f)", __FILE__, __LINE__, __func__, x_value);
+
+	layer->set_source_rgba (0.3, 0.3, 0.3, 0.4);
+	GchartRenderer::setLineAtributes (layer, 1.0, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_MITER, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_BUTT);
+	layer->move_to (GchartRenderer::getXCoord (v, x_value), v.offset_top);
+	layer->line_to (GchartRenderer::getXCoord (v, x_value), v.height - v.offset_bottom);
+	layer->stroke ();
+}
+
+void GchartRenderer::drawCrosshair (const Cairo::RefPtr<Cairo::Context>& layer, const GchartViewport &v, const double &x_coord, const double &y_coord) {
+	g_debug("%s:%d %s (-, -, %f, %f)", __FILE__, __LINE__, __func__, x_coord, y_coord);
+
+	layer->set_source_rgba (0.3, 0.3, 0.3, 0.4);
+	GchartRenderer::setLineAtributes (layer, 1.0, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_MITER, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_BUTT);
+	layer->move_to (x_coord, v.offset_top);
+	layer->line_to (x_coord, v.height - v.offset_bottom);
+	layer->move_to (v.offset_left, y_coord);
+	layer->line_to (v.width - v.offset_right, y_coord);
+	layer->stroke ();
+	layer->set_source_rgba (0, 0, 0, 0.8);
+	layer->arc (x_coord, y_coord, 2 * DOT_RADIUS, 0, 2 * M_PI);
+	layer->stroke ();
+}
+
+void GchartRenderer::drawInfo (const Cairo::RefPtr<Cairo::Context>& layer, const GchartViewport &v, const std::shared_ptr<GchartLabel> &label, const std::shared_ptr<GchartProvider> &y1, const std::shared_ptr<GchartProvider> &y2, const float &x_info_value) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	const int &height = v.height;
+	float h, offset, n;
+	Cairo::TextExtents extents;
+
+	layer->set_font_size (15);
+	GchartTextCache::getDefault ().getTextExtents (layer, y1->getLabel ()->getLabel (), extents);
+	offset = extents.height / 2 + PADDING;
+	const double row_height = extents.height + 13 + 2 * PADDING;
+
+	/* Every provider gets a third (or half) of the height, with more charts
+	 * than rows fit in it the last row tells how many are not shown. */
+	const double block = static_cast<double>(height) / (y2 ? 3 : 2);
+	const std::size_t max_rows = std::max<std::size_t> (1, static_cast<std::size_t>((block - PADDING - extents.height) / row_height));
+
+	n = 1.5;
+	double h_min_y1 = PADDING + extents.height + std::min (y1->size (), max_rows) * row_height;
+
+	if (y2)
+	{
+		double h_min_y2 = PADDING + extents.height + std::min (y2->size (), max_rows) * row_height;
+		h = std::max (block, h_min_y2);
+		n = 2.5;
+
+		/* Y2 info */
+		GchartRenderer::drawInfoRows (layer, v, y2, x_info_value, 1.5 * h - (h_min_y2 / 2), max_rows, extents.height, row_height);
+	} else
+		h = std::max (block, h_min_y1);
+
+	/* Y1 info */
+	GchartRenderer::drawInfoRows (layer, v, y1, x_info_value, 0.5 * h - (h_min_y1 / 2), max_rows, extents.height, row_height);
+
+	/* X info */
+	layer->set_source_rgba (0, 0, 0, 1);
+	GchartRenderer::printText (layer, label->getLabel (), v.width - (v.infobox_width / 2), n * h - offset, MIDDLE_BOTTOM, PADDING / 2);
+	GchartRenderer::printText (layer, label->getValueUnitText (x_info_value, false), v.width - (v.infobox_width / 2), n * h + offset, MIDDLE_BOTTOM, PADDING / 2);
+
+	layer->fill ();
+}
+
+void GchartRenderer::drawInfoRows (const Cairo::RefPtr<Cairo::Context>& layer, const GchartViewport &v, const std::shared_ptr<GchartProvider> &y, const float &x_info_value, const double &top, const std::size_t &max_rows, const double &text_height, const double &row_height) {
+	const double x_text = v.width - (v.infobox_width / 2);
+	const std::size_t shown = (y->size () > max_rows) ? max_rows - 1 : y->size ();
+	double h_actual = top;
+	std::size_t row = 0;
+
+	layer->set_source_rgba (0, 0, 0, 1);
+	GchartRenderer::printText (layer, y->getLabel ()->getLabel (), x_text, h_actual, MIDDLE_BOTTOM, PADDING / 2);
+	h_actual += text_height + PADDING;
+	for (const GchartChart &c : *(y.get ())) {
+		if (row++ == shown) break;
+		const GchartColor& color = c.getColor ();
+		float y_value = c.readValue (x_info_value);
+		layer->set_source_rgba(0, 0, 0, 1);
+		GchartRenderer::printText (layer, y->getLabel ()->getValueUnitText (y_value, false), x_text, h_actual, MIDDLE_BOTTOM, PADDING / 2);
+		layer->set_source_rgba (color._red, color._green, color._blue, color._alpha);
+		layer->move_to (v.width - (v.infobox_width / 4) * 3, h_actual + 7);
+		layer->line_to (v.width - (v.infobox_width / 4), h_actual + 7);
+		layer->stroke ();
+		h_actual += row_height;
+	}
+	if (shown < y->size ()) {
+		layer->set_source_rgba (0, 0, 0, 1);
+		GchartRenderer::printText (layer, std::to_string (y->size () - shown) + " more", x_text, h_actual, MIDDLE_BOTTOM, PADDING / 2);
+	}
+}
+
+void GchartRenderer::drawBuffer (GchartRenderJob &job) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	GchartStatsTimer timer (job.stats, GchartStats::STAGE_BUFFER);
+	int x_lines;
+
+	{
+		GchartStatsTimer t (job.stats, GchartStats::STAGE_OFFSETS);
+		GchartRenderer::calulateOffsets (job);
+	}
+	if (job.isCancelled ()) return;
+
+	{
+		GchartStatsTimer t (job.stats, GchartStats::STAGE_MIN_MAX);
+		GchartRenderer::calculateMinMaxValues (job);
+	}
+	if (job.isCancelled ()) return;
+
+	auto layer = Cairo::Context::create (job.surface);
+
+	{
+		GchartStatsTimer t (job.stats, GchartStats::STAGE_RASTER);
+		GchartRenderer::drawRaster (layer, job, x_lines);
+	}
+
+	GchartStatsTimer t (job.stats, GchartStats::STAGE_CHART);
+	if (job.vector) {
+		std::vector<double> dashes;
+		layer->set_dash(dashes, 0);
+		GchartRenderer::setLineAtributes (layer, 1.0, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_ROUND, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_ROUND);
+		GchartRenderer::drawChartVector (layer, job, job.y1, (static_cast<float>(x_lines) / 10), job.stats);
+		if (job.y2)
+			GchartRenderer::drawChartVector (layer, job, job.y2, (static_cast<float>(x_lines) / 10), job.stats);
+	} else if (job.viewport.density) {
+		GchartRenderer::drawChartDensity (layer, job, job.y1, job.viewport.x_min, job.viewport.x_max, true, job.stats);
+		if (job.y2)
+			GchartRenderer::drawChartDensity (layer, job, job.y2, job.viewport.x_min, job.viewport.x_max, true, job.stats);
+	} else if (job.viewport.x_span > 0) {
+		GchartRenderer::drawChartFollow (layer, job, (static_cast<float>(x_lines) / 10));
+	} else if (job.tiles > 1) {
+		GchartRenderer::drawChartTiled (layer, job, (static_cast<float>(x_lines) / 10), job.stats);
+	} else {
+		std::vector<double> dashes;
+		layer->set_dash(dashes, 0);
+		GchartRenderer::setLineAtributes (layer, 1.0, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_ROUND, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_ROUND);
+		//layer->set_source_rgba (1, 0, 0, 1);
+		GchartRenderer::drawChart (layer, job, job.y1, (static_cast<float>(x_lines) / 10), job.viewport.x_min, job.viewport.x_max, job.stats);
+		if (job.y2) {
+			//layer->set_source_rgba (0, 0.6, 0, 1);
+			GchartRenderer::drawChart (layer, job, job.y2, (static_cast<float>(x_lines) / 10), job.viewport.x_min, job.viewport.x_max, job.stats);
+		}
+	}
+	job.surface->flush ();
+	if (job.hit_index && !job.isCancelled ())
+		job.hits = std::make_shared<const GchartHitIndex> (job.viewport, job.y1, job.y2);
+}
+
+bool GchartRenderer::drawBufferSlice (GchartRenderJob &job, const double &budget) {
+	g_debug("%s:%d %s (%f)", __FILE__, __LINE__, __func__, budget);
+	GchartTraceScope trace ("render", "slice");
+	GchartStatsTimer timer (job.stats, GchartStats::STAGE_BUFFER);
+	GchartRenderSlice &s = job.slice;
+	const auto deadline = std::chrono::steady_clock::now () + std::chrono::duration_cast<std::chrono::steady_clock::duration> (std::chrono::duration<double, std::milli> (budget));
+
+	while (s.step != GchartRenderSlice::STEP_DONE && !job.isCancelled ()) {
+		if (s.step == GchartRenderSlice::STEP_START) {
+			{
+				GchartStatsTimer t (job.stats, GchartStats::STAGE_OFFSETS);
+				GchartRenderer::calulateOffsets (job);
+			}
+			GchartStatsTimer t (job.stats, GchartStats::STAGE_MIN_MAX);
+			GchartRenderer::calculateXRange (job);
+			s.provider = 0;
+			s.chart = job.y1->begin ();
+			s.chart_started = false;
+			s.step = GchartRenderSlice::STEP_MIN_MAX;
+		} else if (s.step == GchartRenderSlice::STEP_MIN_MAX) {
+			GchartStatsTimer t (job.stats, GchartStats::STAGE_MIN_MAX);
+			if (GchartRenderer::sliceMinMax (job, deadline))
+				s.step = GchartRenderSlice::STEP_RASTER;
+		} else if (s.step == GchartRenderSlice::STEP_RASTER) {
+			GchartStatsTimer t (job.stats, GchartStats::STAGE_RASTER);
+			int x_lines;
+			s.layer = Cairo::Context::create (job.surface);
+			GchartRenderer::drawRaster (s.layer, job, x_lines);
+			std::vector<double> dashes;
+			s.layer->set_dash (dashes, 0);
+			GchartRenderer::setLineAtributes (s.layer, 1.0, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_ROUND, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_ROUND);
+			s.x_hint = static_cast<float>(x_lines) / 10;
+			s.column = 0;
+			s.step = GchartRenderSlice::STEP_CHART;
+		} else {
+			GchartStatsTimer t (job.stats, GchartStats::STAGE_CHART);
+			const GchartViewport &v = job.viewport;
+			/* The outer bands also cover the border, like the strips of drawChartTiled (). */
+			const int x1 = s.column;
+			int x2 = static_cast<int>(((x1 == 0) ? v.offset_left : x1) + s.band_width);
+			if (x2 >= v.width - v.offset_right)
+				x2 = v.width;
+
+			const auto start = std::chrono::steady_clock::now ();
+			GchartRenderer::drawBand (job, x1, x2);
+			const double used = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ();
+
+			/* Aim for about four bands per slice. */
+			s.band_width = std::min<double> (v.width, std::max (1.0, s.band_width * budget / 4 / std::max (used, 0.001)));
+			s.column = x2;
+			if (x2 >= v.width) {
+				job.surface->flush ();
+				s.layer.reset ();
+				if (job.hit_index)
+					job.hits = std::make_shared<const GchartHitIndex> (job.viewport, job.y1, job.y2);
+				s.step = GchartRenderSlice::STEP_DONE;
+			}
+		}
+		if (std::chrono::steady_clock::now () >= deadline) break;
+	}
+	return (s.step == GchartRenderSlice::STEP_DONE);
+}
+
+bool GchartRenderer::sliceMinMax (GchartRenderJob &job, const std::chrono::steady_clock::time_point &deadline) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+	GchartRenderSlice &s = job.slice;
+	const GchartViewport &v = job.viewport;
+
+	while (true) {
+		const std::shared_ptr<GchartProvider> &y = (s.provider == 0) ? job.y1 : job.y2;
+		if (s.chart == y->end ()) {
+			GchartRenderer::setYRange (job, y, s.y_min, s.y_max);
+			if (s.provider == 1 || !job.y2) return true;
+			s.provider = 1;
+			s.chart = job.y2->begin ();
+			s.chart_started = false;
+			s.y_min = NAN;
+			s.y_max = NAN;
+			continue;
+		}
+
+		/* Same range as GchartProvider::getYMin (x_min, x_max), in chunks of samples. */
+		if (!s.chart_started) {
+			s.sample = s.chart->lowerBound (v.x_min);
+			s.chart_started = true;
+		}
+		for (int n = 0; n < 65536 && s.sample != s.chart->end () && (*s.sample).first <= v.x_max; ++n, ++s.sample) {
+			const float value = (*s.sample).second;
+			if (!std::isfinite (value)) continue;
+			if (!std::isfinite (s.y_min) || value < s.y_min)
+				s.y_min = value;
+			if (!std::isfinite (s.y_max) || value > s.y_max)
+				s.y_max = value;
+		}
+		if (s.sample == s.chart->end () || (*s.sample).first > v.x_max) {
+			++s.chart;
+			s.chart_started = false;
+		}
+		if (job.isCancelled () || std::chrono::steady_clock::now () >= deadline) return false;
+	}
+}
+
+void GchartRenderer::drawBand (GchartRenderJob &job, const int &x1, const int &x2) {
+	g_debug("%s:%d %s (-, %d, %d)", __FILE__, __LINE__, __func__, x1, x2);
+
+	const GchartViewport &v = job.viewport;
+	const Cairo::RefPtr<Cairo::Context> &layer = job.slice.layer;
+	/* Draw what is just outside of the band too, the clip keeps the neighbours untouched. */
+	const double margin = DOT_RADIUS + 2;
+	const float x_from = (x1 == 0) ? v.x_min : std::max (v.x_min, static_cast<float>(v.x_min + (x1 - margin - v.offset_left) / v.x_scale));
+	const float x_to = (x2 == v.width) ? v.x_max : std::min (v.x_max, static_cast<float>(v.x_min + (x2 + margin - v.offset_left) / v.x_scale));
+
+	layer->save ();
+	layer->rectangle (x1, 0, x2 - x1, v.height);
+	layer->clip ();
+	if (v.density) {
+		/* On the main loop, waiting for the pool would ignore the slice budget. */
+		GchartRenderer::drawChartDensity (layer, job, job.y1, x_from, x_to, false, job.stats);
+		if (job.y2)
+			GchartRenderer::drawChartDensity (layer, job, job.y2, x_from, x_to, false, job.stats);
+	} else {
+		GchartRenderer::drawChart (layer, job, job.y1, job.slice.x_hint, x_from, x_to, job.stats);
+		if (job.y2)
+			GchartRenderer::drawChart (layer, job, job.y2, job.slice.x_hint, x_from, x_to, job.stats);
+	}
+	layer->restore ();
+}
+
+void GchartRenderer::drawChartFollow (const Cairo::RefPtr<Cairo::Context>& layer, GchartRenderJob &job, const float &x_hint) {
+	g_debug("%s:%d %s (-, -, %f)", __FILE__, __LINE__, __func__, x_hint);
+
+	const GchartViewport &v = job.viewport;
+	const double right = v.width - v.offset_right;
+	const double shift = job.previous ? GchartRenderer::getFollowShift (job, *job.previous) : -1;
+	double x_redraw = v.offset_left;
+	float x_from = v.x_min;
+
+	/* The charts get their own layer, clipped to the plot area so it can be shifted. */
+	auto charts = GchartRenderer::createImageSurface (v.width, v.height, v.scale);
+	auto layer_charts = Cairo::Context::create (charts);
+	job.stats.allocations++;
+	layer_charts->rectangle (v.offset_left, 0, right - v.offset_left, v.height);
+	layer_charts->clip ();
+
+	if (shift >= 0) {
+		/* Keep what did not move out, redraw the end of the old charts (its
+		 * last point and dots) and the new part. */
+		const double margin = DOT_RADIUS + 2;
+		x_redraw = std::max<double> (v.offset_left, std::floor (right - shift - margin));
+		layer_charts->save ();
+		layer_charts->rectangle (v.offset_left, 0, x_redraw - v.offset_left, v.height);
+		layer_charts->clip ();
+		layer_charts->set_source (job.previous->charts, -shift, 0);
+		layer_charts->paint ();
+		layer_charts->restore ();
+
+		layer_charts->rectangle (x_redraw, 0, right - x_redraw, v.height);
+		layer_charts->clip ();
+		x_from = std::max (v.x_min, static_cast<float>(v.x_min + (x_redraw - margin - v.offset_left) / v.x_scale));
+	}
+
+	std::vector<double> dashes;
+	layer_charts->set_dash (dashes, 0);
+	GchartRenderer::setLineAtributes (layer_charts, 1.0, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_ROUND, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_ROUND);
+	GchartRenderer::drawChart (layer_charts, job, job.y1, x_hint, x_from, v.x_max, job.stats);
+	if (job.y2)
+		GchartRenderer::drawChart (layer_charts, job, job.y2, x_hint, x_from, v.x_max, job.stats);
+	charts->flush ();
+
+	layer->set_source (charts, 0, 0);
+	layer->paint ();
+
+	auto reuse = std::make_shared<GchartRenderReuse> ();
+	reuse->charts = charts;
+	reuse->viewport = v;
+	reuse->y1_min = job.y1->_y_min;
+	reuse->y1_max = job.y1->_y_max;
+	reuse->y1_revision = job.y1->_revision;
+	reuse->has_y2 = static_cast<bool>(job.y2);
+	reuse->y2_min = job.y2 ? job.y2->_y_min : NAN;
+	reuse->y2_max = job.y2 ? job.y2->_y_max : NAN;
+	reuse->y2_revision = job.y2 ? job.y2->_revision : 0;
+	job.reuse = reuse;
+	/* Do not keep a chain of buffers alive. */
+	job.previous.reset ();
+}
+
+double GchartRenderer::getFollowShift (const GchartRenderJob &job, const GchartRenderReuse &previous) {
+	const GchartViewport &v = job.viewport;
+	const GchartViewport &p = previous.viewport;
+
+	if (v.width != p.width || v.height != p.height || v.offset_left != p.offset_left || v.offset_right != p.offset_right ||
+		v.offset_top != p.offset_top || v.offset_bottom != p.offset_bottom || v.x_scale != p.x_scale || v.x_span != p.x_span ||
+		v.plot_lines != p.plot_lines || v.plot_dots != p.plot_dots || v.minmax_threshold != p.minmax_threshold || v.minmax_coverage != p.minmax_coverage || v.scale != p.scale)
+		return -1;
+	if (job.y1->_revision != previous.y1_revision || job.y1->_y_min != previous.y1_min || job.y1->_y_max != previous.y1_max)
+		return -1;
+	if (static_cast<bool>(job.y2) != previous.has_y2)
+		return -1;
+	if (job.y2 && (job.y2->_revision != previous.y2_revision || job.y2->_y_min != previous.y2_min || job.y2->_y_max != previous.y2_max))
+		return -1;
+
+	/* x_min is a whole number of pixels away from the one before, see calculateXRange (). */
+	const double shift = (static_cast<double>(v.x_min) - p.x_min) * v.x_scale;
+	if (shift < 0 || shift >= v.width - v.offset_left - v.offset_right || std::abs (shift - std::round (shift)) > 0.01)
+		return -1;
+	return std::round (shift);
+}
+
+void GchartRenderer::drawChartTiled (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, const float &x_hint, GchartStats &stats) {
+	g_debug("%s:%d %s (-, -, %f)", __FILE__, __LINE__, __func__, x_hint);
+
+	const GchartViewport &v = job.viewport;
+	const double plot_width = v.width - v.offset_left - v.offset_right;
+	const double strip_width = std::ceil (plot_width / job.tiles);
+	/* Strips also draw what is just outside of them, so lines and dots crossing the edge are complete. */
+	const double margin = DOT_RADIUS + 2;
+	std::vector<Cairo::RefPtr<Cairo::ImageSurface>> strips (job.tiles);
+	std::vector<GchartStats> strip_stats (job.tiles);
+	std::vector<std::future<void>> tasks;
+
+	for (unsigned int i = 0; i < job.tiles; ++i) {
+		/* The outer strips also cover the border, so the first and last point are drawn like the untiled version. */
+		const int x1 = (i == 0) ? 0 : static_cast<int>(v.offset_left + i * strip_width);
+		const int x2 = (i == job.tiles - 1) ? v.width : static_cast<int>(v.offset_left + (i + 1) * strip_width);
+		if (x2 <= x1) continue;
+
+		tasks.push_back (GchartThreadPool::getDefault ().push ([&job, &v, &strips, &strip_stats, i, x1, x2, x_hint, margin] () {
+			GchartTraceScope trace ("render", "strip");
+			const float x_from = (x1 == 0) ? v.x_min : std::max (v.x_min, static_cast<float>(v.x_min + (x1 - margin - v.offset_left) / v.x_scale));
+			const float x_to = (x2 == v.width) ? v.x_max : std::min (v.x_max, static_cast<float>(v.x_min + (x2 + margin - v.offset_left) / v.x_scale));
+
+			auto surface = GchartRenderer::createImageSurface (x2 - x1, v.height, v.scale);
+			auto strip = Cairo::Context::create (surface);
+			strip->translate (-x1, 0);
+			GchartRenderer::setLineAtributes (strip, 1.0, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_ROUND, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_ROUND);
+			strip_stats[i].allocations++;
+			GchartRenderer::drawChart (strip, job, job.y1, x_hint, x_from, x_to, strip_stats[i]);
+			if (job.y2)
+				GchartRenderer::drawChart (strip, job, job.y2, x_hint, x_from, x_to, strip_stats[i]);
+			surface->flush ();
+			strips[i] = surface;
+		}));
+	}
+
+	for (std::future<void> &t : tasks)
+		t.get ();
+	for (const GchartStats &s : strip_stats)
+		stats.addCounters (s);
+	if (job.isCancelled ()) return;
+
+	for (unsigned int i = 0; i < job.tiles; ++i) {
+		if (!strips[i]) continue;
+		const int x1 = (i == 0) ? 0 : static_cast<int>(v.offset_left + i * strip_width);
+		layer->set_source (strips[i], x1, 0);
+		layer->paint ();
+	}
+}
+
+void GchartRenderer::drawChart (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const float &x_hint, const float &x_from, const float &x_to, GchartStats &stats) {
+	g_debug("%s:%d %s (-, -, -, %f, %f, %f)", __FILE__, __LINE__, __func__, x_hint, x_from, x_to);
+
+	const GchartViewport &v = job.viewport;
+	/* Charts with the same colour are drawn as one path, with one stroke and one fill. */
+	std::vector<std::vector<const GchartChart*>> groups;
+	std::map<std::tuple<double, double, double, double>, std::size_t> group_index;
+
+	for (const GchartChart &c : *(y.get ())) {
+		if (job.isCancelled ()) return;
+
+		if (GchartRenderer::drawChartMinMax (layer, job, y, c, x_from, x_to, stats))
+			continue;
+
+		const GchartColor& color = c.getColor ();
+		const auto group = group_index.emplace (std::make_tuple (color._red, color._green, color._blue, color._alpha), groups.size ()).first;
+		if (group->second == groups.size ())
+			groups.emplace_back ();
+		groups[group->second].push_back (&c);
+	}
+
+	std::vector<Vertex> dots;
+	bool first = true;
+	auto add = [&] (const std::shared_ptr<GchartPoint> &point) {
+		stats.points++;
+		if (!std::isfinite (point->getX ()) || !std::isfinite (point->getY ())) return;
+
+		const double x_coord = GchartRenderer::getXCoord (v, point->getX ());
+		const double y_coord = v.height - GchartRenderer::getYCoord (v, point->getY (), y);
+		if (v.plot_lines) {
+			if (first)
+				layer->move_to (x_coord, y_coord);
+			else
+				layer->line_to (x_coord, y_coord);
+		}
+		if (v.plot_dots)
+			dots.push_back ({x_coord, y_coord});
+		first = false;
+		stats.vertices++;
+	};
+
+	for (const std::vector<const GchartChart*> &group : groups) {
+		const GchartColor& color = group.front ()->getColor ();
+
+		layer->begin_new_path ();
+		dots.clear ();
+		for (const GchartChart *c : group) {
+			std::shared_ptr<GchartPoint> point, point_prev;
+
+			first = true;
+			/* Every point is a new GchartPoint. */
+			point = c->getPoint (x_from);
+			stats.allocations++;
+			point_prev = point;
+			add (point);
+
+			while ((point = c->getNextPoint (point_prev, point_prev->getX () + x_hint)) != nullptr) {
+				stats.allocations++;
+				point_prev = point;
+
+				if (job.isCancelled ()) return;
+				if (point->getX () < x_from) break;
+				if (point->getX () > x_to) break;
+				add (point);
+			}
+
+			add (c->getPoint (x_to));
+			stats.allocations++;
+		}
+
+		layer->set_source_rgba (color._red, color._green, color._blue, color._alpha);
+		if (v.plot_lines)
+			layer->stroke ();
+		if (v.plot_dots) {
+			for (const Vertex &p : dots) {
+				layer->new_sub_path ();
+				layer->arc (p.x, p.y, DOT_RADIUS, 0, 2 * M_PI);
+			}
+			layer->fill ();
+		}
+	}
+}
+
+bool GchartRenderer::drawChartMinMax (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const GchartChart &c, const float &x_from, const float &x_to, GchartStats &stats) {
+	g_debug("%s:%d %s (-, -, -, %d, %f, %f)", __FILE__, __LINE__, __func__, c.getIdentifier (), x_from, x_to);
+
+	const GchartViewport &v = job.viewport;
+	if (v.minmax_threshold <= 0 || c.size () < 2) return false;
+	const float x_first = c.begin ()->first;
+	const float x_last = c.last ()->first;
+	if (!(x_last > x_first)) return false;
+	/* The average density of the whole chart, cheap and close enough to choose. */
+	if (c.size () / ((x_last - x_first) * v.x_scale) < v.minmax_threshold) return false;
+
+	cairo_surface_t *target = cairo_get_target (layer->cobj ());
+	if (cairo_surface_get_type (target) != CAIRO_SURFACE_TYPE_IMAGE || cairo_image_surface_get_format (target) != CAIRO_FORMAT_ARGB32) return false;
+	if (!v.plot_lines && !v.plot_dots) return true;
+
+	/* The layers are only translated (the strips of drawChartTiled ()). */
+	double x_offset = 0, y_offset = 0;
+	layer->user_to_device (x_offset, y_offset);
+
+	/* Columns are device units, every one is scale pixels wide (HiDPI, see createImageSurface ()). */
+	double x_scale, y_scale;
+	cairo_surface_get_device_scale (target, &x_scale, &y_scale);
+	const int scale = static_cast<int>(std::lround (x_scale));
+	if (scale < 1 || x_scale != scale || y_scale != scale) return false;
+
+	cairo_surface_flush (target);
+	unsigned char *data = cairo_image_surface_get_data (target);
+	const int stride = cairo_image_surface_get_stride (target);
+	/* Pixels are written directly, so respect the clip (the bands of drawBufferSlice ()). */
+	double clip_x1, clip_y1, clip_x2, clip_y2;
+	layer->get_clip_extents (clip_x1, clip_y1, clip_x2, clip_y2);
+	const int col_from = std::max (0, static_cast<int>(std::floor (clip_x1 + x_offset)));
+	const int col_to = std::min (cairo_image_surface_get_width (target) / scale, static_cast<int>(std::ceil (clip_x2 + x_offset)));
+	const int row_from_clip = std::max (0, static_cast<int>(std::floor ((clip_y1 + y_offset) * scale)));
+	const int row_to_clip = std::min (cairo_image_surface_get_height (target), static_cast<int>(std::ceil ((clip_y2 + y_offset) * scale)));
+
+	const GchartColor &color = c.getColor ();
+	/* At this density the dots merge into a band around the line. */
+	const double half_width = v.plot_dots ? DOT_RADIUS : 0.5;
+
+	/* Blend a vertical span from lo to hi (device units) into column col. */
+	auto drawSpan = [&] (const int &col, const double &span_lo, const double &span_hi) {
+		double lo = (span_lo - half_width) * scale;
+		double hi = (span_hi + half_width) * scale;
+		if (!v.minmax_coverage) {
+			lo = std::round (lo);
+			hi = std::max (lo + 1, std::round (hi));
+		}
+		const int row_from = std::max (row_from_clip, static_cast<int>(std::floor (lo)));
+		const int row_to = std::min (row_to_clip, static_cast<int>(std::ceil (hi)));
+		for (int row = row_from; row < row_to; ++row) {
+			const double coverage = std::min<double> (row + 1, hi) - std::max<double> (row, lo);
+			const double alpha = color._alpha * coverage;
+			for (int pixel_col = col * scale; pixel_col < (col + 1) * scale; ++pixel_col) {
+				unsigned char *p = data + static_cast<std::size_t>(row) * stride + static_cast<std::size_t>(pixel_col) * 4;
+				uint32_t pixel;
+
+				/* Premultiplied ARGB in native byte order, blended with OVER. */
+				std::memcpy (&pixel, p, sizeof (pixel));
+				const uint32_t a = static_cast<uint32_t>(std::lround (255 * alpha + ((pixel >> 24) & 0xff) * (1 - alpha)));
+				const uint32_t r = static_cast<uint32_t>(std::lround (255 * alpha * color._red + ((pixel >> 16) & 0xff) * (1 - alpha)));
+				const uint32_t g = static_cast<uint32_t>(std::lround (255 * alpha * color._green + ((pixel >> 8) & 0xff) * (1 - alpha)));
+				const uint32_t b = static_cast<uint32_t>(std::lround (255 * alpha * color._blue + (pixel & 0xff) * (1 - alpha)));
+				pixel = (a << 24) | (r << 16) | (g << 8) | b;
+				std::memcpy (p, &pixel, sizeof (pixel));
+			}
+		}
+	};
+
+	GchartRenderer::collectSpans (job, y, c, x_from, x_to, x_offset, y_offset, col_from, col_to, stats, drawSpan);
+	cairo_surface_mark_dirty (target);
+	return true;
+}
+
+void GchartRenderer::drawChartDensity (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const float &x_from, const float &x_to, const bool &parallel, GchartStats &stats) {
+	g_debug("%s:%d %s (-, -, -, %f, %f, %d)", __FILE__, __LINE__, __func__, x_from, x_to, parallel);
+
+	const GchartViewport &v = job.viewport;
+	if (y->size () == 0) return;
+
+	/* Only the part of the plot area inside the clip (the bands of drawBufferSlice ()). */
+	double clip_x1, clip_y1, clip_x2, clip_y2;
+	layer->get_clip_extents (clip_x1, clip_y1, clip_x2, clip_y2);
+	const int col_from = static_cast<int>(std::floor (std::max<double> (v.offset_left, clip_x1)));
+	const int col_to = static_cast<int>(std::ceil (std::min<double> (v.width - v.offset_right, clip_x2)));
+	const int row_from = static_cast<int>(std::floor (std::max<double> (v.offset_top, clip_y1)));
+	const int row_to = static_cast<int>(std::ceil (std::min<double> (v.height - v.offset_bottom, clip_y2)));
+	if (col_to <= col_from || row_to <= row_from) return;
+	const std::size_t width = col_to - col_from;
+
+	/* Columns are device units, rows are counted per pixel (HiDPI, see createImageSurface ()). */
+	double x_scale, y_scale;
+	cairo_surface_get_device_scale (cairo_get_target (layer->cobj ()), &x_scale, &y_scale);
+	const int scale = std::max (1, static_cast<int>(std::lround (y_scale)));
+	const int pixel_row_from = row_from * scale;
+	const int pixel_row_to = row_to * scale;
+	const std::size_t height = pixel_row_to - pixel_row_from;
+
+	/* Every task counts its share of the charts in its own buffer, a chart
+	 * adds one to every pixel it passes. */
+	const std::size_t n_tasks = parallel ? std::max<std::size_t> (1, std::min (GchartThreadPool::getDefault ().size (), y->size ())) : 1;
+	std::vector<std::vector<uint32_t>> counts (n_tasks);
+	std::vector<GchartStats> task_stats (n_tasks);
+	auto count = [&] (const std::size_t &task) {
+		std::vector<uint32_t> &buffer = counts[task];
+		buffer.assign (width * height, 0);
+		auto addSpan = [&] (const int &column, const double &lo, const double &hi) {
+			const int r1 = std::max (pixel_row_from, static_cast<int>(std::floor (lo * scale)));
+			const int r2 = std::min (pixel_row_to, static_cast<int>(std::floor (hi * scale)) + 1);
+			for (int row = r1; row < r2; ++row)
+				buffer[(row - pixel_row_from) * width + (column - col_from)]++;
+		};
+		std::size_t i = 0;
+		for (const GchartChart &c : *(y.get ())) {
+			if ((i++ % n_tasks) != task) continue;
+			if (job.isCancelled ()) return;
+			GchartRenderer::collectSpans (job, y, c, x_from, x_to, 0, 0, col_from, col_to, task_stats[task], addSpan);
+		}
+	};
+
+	std::vector<std::future<void>> tasks;
+	for (std::size_t t = 1; t < n_tasks; ++t) {
+		tasks.push_back (GchartThreadPool::getDefault ().push ([&count, t] () {
+			GchartTraceScope trace ("render", "density");
+			count (t);
+		}));
+	}
+	count (0);
+	for (std::future<void> &t : tasks)
+		t.get ();
+	for (const GchartStats &s : task_stats)
+		stats.addCounters (s);
+	if (job.isCancelled ()) return;
+
+	std::vector<uint32_t> &total = counts[0];
+	uint32_t max_count = 0;
+	for (std::size_t i = 0; i < total.size (); ++i) {
+		for (std::size_t t = 1; t < n_tasks; ++t)
+			total[i] += counts[t][i];
+		max_count = std::max (max_count, total[i]);
+	}
+	if (max_count == 0) return;
+
+	/* Colour map the counts on a log scale, pixels no chart passes stay transparent. */
+	auto image = GchartRenderer::createImageSurface (width, row_to - row_from, scale);
+	stats.allocations++;
+	image->flush ();
+	unsigned char *data = image->get_data ();
+	const int stride = image->get_stride ();
+	const double log_scale = 1.0 / std::log1p (static_cast<double>(max_count));
+	for (std::size_t row = 0; row < height; ++row) {
+		for (std::size_t col = 0; col < width; ++col) {
+			const uint32_t n = total[row * width + col];
+			if (n == 0) continue;
+			const uint32_t pixel = GchartRenderer::densityColor (std::log1p (static_cast<double>(n)) * log_scale);
+			for (int i = 0; i < scale; ++i)
+				std::memcpy (data + row * stride + (col * scale + i) * 4, &pixel, sizeof (pixel));
+		}
+	}
+	image->mark_dirty ();
+
+	layer->save ();
+	layer->set_source (image, col_from, row_from);
+	layer->paint ();
+	layer->restore ();
+}
+
+uint32_t GchartRenderer::densityColor (const double &t) {
+	/* Viridis, sampled at 0, 1/4, 1/2, 3/4 and 1. */
+	static const double stops[5][3] = {{68, 1, 84}, {59, 82, 139}, {33, 145, 140}, {94, 201, 98}, {253, 231, 37}};
+	const double f = std::min (1.0, std::max (0.0, t)) * 4;
+	const int i = std::min (3, static_cast<int>(f));
+	const double w = f - i;
+	uint32_t pixel = 0xff000000u;
+	for (int k = 0; k < 3; ++k)
+		pixel |= static_cast<uint32_t>(std::lround (stops[i][k] + w * (stops[i + 1][k] - stops[i][k]))) << (16 - 8 * k);
+	return pixel;
+}
+
+void GchartRenderer::collectSpans (const GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const GchartChart &c, const float &x_from, const float &x_to, const double &x_offset, const double &y_offset, const int &col_from, const int &col_to, GchartStats &stats, const std::function<void(const int&, const double&, const double&)> &span) {
+	const GchartViewport &v = job.viewport;
+	auto emit = [&] (const int &column, const double &lo, const double &hi) {
+		if (column < col_from || column >= col_to) return;
+		span (column, lo, hi);
+		stats.columns++;
+	};
+
+
+	/* The span of every column, a line also covers the points where it
+	 * enters and leaves a column, so adjacent columns connect. */
+	int col = 0;
+	bool open = false;
+	double lo = 0, hi = 0, x_prev = 0, y_prev = 0;
+	auto add = [&] (const double &x_coord, const double &y_coord) {
+		const int k = static_cast<int>(std::floor (x_coord));
+		if (open && k == col) {
+			lo = std::min (lo, y_coord);
+			hi = std::max (hi, y_coord);
+		} else if (open && v.plot_lines && k > col) {
+			const double slope = (y_coord - y_prev) / (x_coord - x_prev);
+			const double y_exit = y_prev + (col + 1 - x_prev) * slope;
+			emit (col, std::min (lo, y_exit), std::max (hi, y_exit));
+			for (int i = std::max (col + 1, col_from - 1); i < std::min (k, col_to); ++i) {
+				const double y1 = y_prev + (i - x_prev) * slope;
+				const double y2 = y_prev + (i + 1 - x_prev) * slope;
+				emit (i, std::min (y1, y2), std::max (y1, y2));
+			}
+			const double y_entry = y_prev + (k - x_prev) * slope;
+			col = k;
+			lo = std::min (y_coord, y_entry);
+			hi = std::max (y_coord, y_entry);
+		} else {
+			if (open)
+				emit (col, lo, hi);
+			col = k;
+			lo = hi = y_coord;
+			open = true;
+		}
+		x_prev = x_coord;
+		y_prev = y_coord;
+	};
+	auto addValue = [&] (const float &x, const float &value) {
+		stats.points++;
+		if (!std::isfinite (x) || !std::isfinite (value)) return;
+		add (GchartRenderer::getXCoord (v, x) + x_offset, v.height - GchartRenderer::getYCoord (v, value, y) + y_offset);
+	};
+	auto interpolate = [] (const GchartMap::value_type &a, const GchartMap::value_type &b, const float &x) {
+		return a.second + (x - a.first) * (b.second - a.second) / (b.first - a.first);
+	};
+
+	/* Like drawChart (), start and end at x_from and x_to. */
+	GchartMap::const_iterator it = c.lowerBound (x_from);
+	GchartMap::const_iterator prev = c.end ();
+	if (it != c.begin () && it != c.end ())
+		addValue (x_from, interpolate (*std::prev (it), *it, x_from));
+	for (uint64_t n = 0; it != c.end () && it->first <= x_to; ++it, ++n) {
+		if ((n & 0xffff) == 0 && job.isCancelled ()) break;
+		addValue (it->first, it->second);
+		prev = it;
+	}
+	if (prev != c.end () && it != c.end () && it->first > x_to)
+		addValue (x_to, interpolate (*prev, *it, x_to));
+	if (open)
+		emit (col, lo, hi);
+
+}
+
+void GchartRenderer::drawChartVector (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const float &x_hint, GchartStats &stats) {
+	g_debug("%s:%d %s (-, -, -, %f)", __FILE__, __LINE__, __func__, x_hint);
+
+	const GchartViewport &v = job.viewport;
+	const double tolerance = std::max (job.tolerance, 0.01);
+	std::vector<Vertex> path;
+	std::vector<bool> keep;
+
+	for (const GchartChart &c : *(y.get ())) {
+		const GchartColor& color = c.getColor ();
+		std::shared_ptr<GchartPoint> point, point_prev;
+		bool skipped = false;
+		Vertex last = {0, 0};
+
+		if (job.isCancelled ()) return;
+
+		/* Same walk as drawChart (), but only points that moved more than the
+		 * tolerance from the previous one are kept (the last one always is). */
+		path.clear ();
+		auto add = [&] (const std::shared_ptr<GchartPoint> &p) {
+			stats.points++;
+			if (!std::isfinite (p->getX ()) || !std::isfinite (p->getY ())) return;
+			const Vertex vertex = {GchartRenderer::getXCoord (v, p->getX ()), v.height - GchartRenderer::getYCoord (v, p->getY (), y)};
+			if (!path.empty () && std::hypot (vertex.x - path.back ().x, vertex.y - path.back ().y) < tolerance) {
+				last = vertex;
+				skipped = true;
+				return;
+			}
+			path.push_back (vertex);
+			skipped = false;
+		};
+
+		point = c.getPoint (v.x_min);
+		stats.allocations++;
+		point_prev = point;
+		add (point);
+		while ((point = c.getNextPoint (point_prev, point_prev->getX () + x_hint)) != nullptr) {
+			stats.allocations++;
+			point_prev = point;
+			if (job.isCancelled ()) return;
+			if (point->getX () < v.x_min || point->getX () > v.x_max) break;
+			add (point);
+		}
+		add (c.getPoint (v.x_max));
+		stats.allocations++;
+		if (skipped)
+			path.push_back (last);
+		if (path.empty ()) continue;
+
+		GchartRenderer::simplifyPath (path, tolerance, keep);
+
+		layer->begin_new_path ();
+		layer->set_source_rgba (color._red, color._green, color._blue, color._alpha);
+		if (v.plot_lines) {
+			layer->move_to (path.front ().x, path.front ().y);
+			for (std::size_t i = 1; i < path.size (); ++i) {
+				if (!keep[i]) continue;
+				layer->line_to (path[i].x, path[i].y);
+				stats.vertices++;
+			}
+			stats.vertices++;
+			layer->stroke ();
+		}
+		if (v.plot_dots) {
+			/* Dots are not simplified, but points closer than the tolerance were already dropped. */
+			for (const Vertex &p : path) {
+				layer->new_sub_path ();
+				layer->arc (p.x, p.y, DOT_RADIUS, 0, 2 * M_PI);
+				stats.vertices++;
+			}
+			layer->fill ();
+		}
+	}
+}
+
+void GchartRenderer::simplifyPath (const std::vector<Vertex> &path, const double &tolerance, std::vector<bool> &keep) {
+	/* Douglas-Peucker, with an explicit stack so long paths can not overflow the call stack. */
+	std::vector<std::pair<std::size_t, std::size_t>> stack;
+
+	keep.assign (path.size (), false);
+	if (path.empty ()) return;
+	keep.front () = true;
+	keep.back () = true;
+	if (path.size () > 2)
+		stack.emplace_back (0, path.size () - 1);
+
+	while (!stack.empty ()) {
+		const std::size_t first = stack.back ().first;
+		const std::size_t last = stack.back ().second;
+		stack.pop_back ();
+
+		const double dx = path[last].x - path[first].x;
+		const double dy = path[last].y - path[first].y;
+		const double length = std::hypot (dx, dy);
+		double max_distance = 0;
+		std::size_t index = first;
+
+		for (std::size_t i = first + 1; i < last; ++i) {
+			double distance;
+			if (length > 0)
+				distance = std::fabs (dy * (path[i].x - path[first].x) - dx * (path[i].y - path[first].y)) / length;
+			else
+				distance = std::hypot (path[i].x - path[first].x, path[i].y - path[first].y);
+			if (distance > max_distance) {
+				max_distance = distance;
+				index = i;
+			}
+		}
+
+		if (max_distance > tolerance) {
+			keep[index] = true;
+			if (index - first > 1)
+				stack.emplace_back (first, index);
+			if (last - index > 1)
+				stack.emplace_back (index, last);
+		}
+	}
+}
+
+double GchartRenderer::getTickStep (const double &range, const int &lines) {
+	if (!(range > 0) || !std::isfinite (range) || lines < 1) return 0;
+	/* At least range / lines, rounded up to 1, 2 or 5 times a power of ten. */
+	const double step = range / lines;
+	const double magnitude = std::pow (10.0, std::floor (std::log10 (step)));
+	for (const double m : TICK_MULTIPLES) {
+		if (step <= m * magnitude)
+			return m * magnitude;
+	}
+	return 10 * magnitude;
+}
+
+double GchartRenderer::getXCoord (const GchartViewport &v, const float &x) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	if (!std::isfinite (x)) return v.offset_left;
+	return v.offset_left + ((x - v.x_min) * v.x_scale);
+}
+
+double GchartRenderer::getYCoord (const GchartViewport &v, const float &y, const std::shared_ptr<GchartProvider> &y_provider) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	if (!std::isfinite (y)) return v.offset_bottom;
+	return v.offset_bottom + ((y - y_provider->_y_min) * y_provider->_y_scale);
+}
+
+void GchartRenderer::calculateMinMaxValues (GchartRenderJob &job) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	GchartRenderer::calculateXRange (job);
+	GchartRenderer::calculateYRange (job, job.y1, job.y1_autoscale);
+	if (job.y2)
+		GchartRenderer::calculateYRange (job, job.y2, job.y2_autoscale);
+}
+
+void GchartRenderer::calculateYRange (GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const std::shared_ptr<GchartAutoscale> &autoscale) {
+	const GchartViewport &v = job.viewport;
+	if (autoscale) {
+		float y_min, y_max;
+		autoscale->getYRange (*y, v.x_min, v.x_max, y_min, y_max);
+		GchartRenderer::setYRange (job, y, y_min, y_max);
+	} else {
+		GchartRenderer::setYRange (job, y, y->getYMin (v.x_min, v.x_max), y->getYMax (v.x_min, v.x_max));
+	}
+}
+
+void GchartRenderer::setYRange (GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const float &y_min, const float &y_max) {
+	const GchartViewport &v = job.viewport;
+	y->_y_min = y_min;
+	y->_y_max = y_max;
+	y->_y_scale = (v.height - v.offset_top - v.offset_bottom) / (y_max - y_min);
+}
+
+void GchartRenderer::calculateXRange (GchartRenderJob &job) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	GchartViewport &v = job.viewport;
+	float x_min_data, x_max_data, x_span_zoom;
+	// TODO: also check job.y2
+	x_min_data = job.y1->getXMin ();
+	x_max_data = job.y1->getXMax ();
+
+	if (v.x_span > 0 && std::isfinite (x_max_data)) {
+		/* x_max is rounded up to whole pixels, then the next buffer is this
+		 * one shifted by whole pixels, see drawChartFollow (). */
+		v.x_scale = (v.width - v.offset_left - v.offset_right) / v.x_span;
+		v.x_max = std::ceil (x_max_data * v.x_scale) / v.x_scale;
+		v.x_min = v.x_max - v.x_span;
+		return;
+	}
+
+	/* If zoom is bigger than 1.0 then adjust the minimum and maximum x value to it. */
+	if (std::isfinite (v.zoom) && v.zoom > 1.0f) {
+		x_span_zoom = (x_max_data - x_min_data) / ( 2 * v.zoom);
+		/* If x_center is not set, set it to the middle of the real window. */
+		if (!std::isfinite (v.x_center)) {
+			v.x_center = (x_max_data + x_min_data) /  2;
+		} else {
+			/* If x_center was set, check if it is within the minimum and maximum. */
+			v.x_center = MAX(x_min_data + x_span_zoom, v.x_center);
+			v.x_center = MIN(x_max_data - x_span_zoom, v.x_center);
+		}
+		v.x_max = v.x_center + x_span_zoom;
+		v.x_min = v.x_center - x_span_zoom;
+	} else {
+		v.zoom = 1.0;
+		v.x_max = x_max_data;
+		v.x_min = x_min_data;
+	}
+
+	v.x_scale = (v.width - v.offset_left - v.offset_right) / (v.x_max - v.x_min);
+	return;
+}
+
+void GchartRenderer::drawRaster (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, int &x_lines) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	const GchartViewport &v = job.viewport;
+	const int &width = v.width;
+	const int &height = v.height;
+
+	Cairo::TextExtents extents;
+	int y_lines;
+
+	/* fill the background */
+	layer->set_source_rgb (1, 1, 1);
+	layer->rectangle (0, 0, width, height);
+	layer->fill ();
+
+	/* x and y1 axis */
+	layer->set_source_rgb (0, 0, 0);
+	layer->move_to (v.offset_left, v.offset_top);
+	/* y1-axis */
+	layer->line_to (v.offset_left, height - v.offset_bottom);
+	/* x-axis */
+	layer->line_to (width - v.offset_right, height - v.offset_bottom);
+	/* y2-axis */
+	if (job.y2)
+		layer->line_to(width - v.offset_right, v.offset_top);
+
+	GchartRenderer::setLineAtributes (layer, 1.0, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_MITER, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_BUTT);
+	layer->stroke ();
+
+	GchartTextCache::getDefault ().getTextExtents (layer, "0", extents);
+	x_lines = (width - v.offset_left - v.offset_right) / (extents.width * 14);
+	y_lines = (height - v.offset_top - v.offset_bottom) / (extents.height * 4);
+
+	/* Ticks are whole multiples of the step, so the same values (and cached
+	 * labels) come back while panning. Ticks next to the end labels are left out. */
+	const double x_step = GchartRenderer::getTickStep (v.x_max - v.x_min, x_lines);
+	const double x_margin = extents.width * 7;
+	for (double k = std::ceil (v.x_min / x_step); x_step > 0 && k * x_step < v.x_max; ++k) {
+		const double value = k * x_step;
+		const double x = GchartRenderer::getXCoord (v, value);
+		if (x < v.offset_left + x_margin || x > width - v.offset_right - x_margin) continue;
+		verticalSubLine (layer, value, job.label, x, height - v.offset_bottom, v.offset_top);
+	}
+
+	const double y_margin = extents.height * 2;
+	const double y1_step = GchartRenderer::getTickStep (job.y1->_y_max - job.y1->_y_min, y_lines);
+	for (double k = std::ceil (job.y1->_y_min / y1_step); y1_step > 0 && k * y1_step < job.y1->_y_max; ++k) {
+		const double value = k * y1_step;
+		const double y = height - GchartRenderer::getYCoord (v, value, job.y1);
+		if (y < v.offset_top + y_margin || y > height - v.offset_bottom - y_margin) continue;
+		horizontalSubLine (layer, value, job.y1->getLabel (), v.offset_left, y, width - v.offset_right);
+	}
+
+	/* draw the first and last labels on the X axis */
+	GchartRenderer::printText2 (layer, v.x_min, job.label, v.offset_left, height - v.offset_bottom, MIDDLE_TOP, 5);
+	GchartRenderer::printText2 (layer, v.x_max, job.label, width - v.offset_right, height - v.offset_bottom, MIDDLE_TOP, 5);
+
+	/* draw the first and last labels on the Y1 axis */
+	GchartRenderer::printText2 (layer, job.y1->_y_min, job.y1->getLabel (), v.offset_left, height - v.offset_bottom, RIGHT_MIDDLE, 5);
+	GchartRenderer::printText2 (layer, job.y1->_y_max, job.y1->getLabel (), v.offset_left, v.offset_top, RIGHT_MIDDLE, 5);
+
+	if (job.y2) {
+		/* draw the first and last labels on the Y2 axis */
+		GchartRenderer::printText2 (layer, job.y2->_y_min, job.y2->getLabel (), width - v.offset_right, height - v.offset_bottom, LEFT_MIDDLE, 5);
+		GchartRenderer::printText2 (layer, job.y2->_y_max, job.y2->getLabel (), width - v.offset_right, v.offset_top, LEFT_MIDDLE, 5);
+
+		const double y2_step = GchartRenderer::getTickStep (job.y2->_y_max - job.y2->_y_min, y_lines);
+		for (double k = std::ceil (job.y2->_y_min / y2_step); y2_step > 0 && k * y2_step < job.y2->_y_max; ++k) {
+			const double value = k * y2_step;
+			const double y = height - GchartRenderer::getYCoord (v, value, job.y2);
+			if (y < v.offset_top + y_margin || y > height - v.offset_bottom - y_margin) continue;
+			GchartRenderer::printText2 (layer, value, job.y2->getLabel (), width - v.offset_right, y, LEFT_MIDDLE, 5);
+		}
+	}
+
+	layer->set_source_rgba (1, 0, 0, 0.2);
+	layer->fill ();
+}
+
+void GchartRenderer::setLineAtributes (const Cairo::RefPtr<Cairo::Context>& layer, const double &width, const CAIRO_ENUM_NS_CONTEXT::LineJoin &line_join, const CAIRO_ENUM_NS_CONTEXT::LineCap &line_cap) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	layer->set_line_width (width);
+	layer->set_line_join (line_join);
+	layer->set_line_cap (line_cap);
+}
+
+void GchartRenderer::drawSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &x1, const double &y1, const double &x2, const double &y2) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	std::vector<double> dashes = {6.0};
+	layer->set_source_rgba (0, 0, 0, 0.8);
+	GchartRenderer::setLineAtributes (layer, 0.25, CAIRO_ENUM_NS_CONTEXT::LineJoin::LINEJOIN_MITER, CAIRO_ENUM_NS_CONTEXT::LineCap::LINECAP_BUTT);
+	layer->set_dash(dashes, 0);
+	layer->move_to(x1, y1);
+	layer->line_to(x2, y2);
+}
+
+void GchartRenderer::verticalSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &value, const std::shared_ptr<GchartLabel> &label, const double &x1, const double &y1, const double &y2) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	layer->set_source_rgba (0, 0, 0, 1);
+	GchartRenderer::printText2 (layer, value, label, x1, y1, MIDDLE_TOP, 5);
+	GchartRenderer::drawSubLine (layer, x1, y1, x1, y2);
+	layer->stroke ();
+	layer->fill ();
+}
+
+void GchartRenderer::horizontalSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &value, const std::shared_ptr<GchartLabel> &label, const double &x1, const double &y1, const double &x2) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	layer->set_source_rgba (0, 0, 0, 1);
+	GchartRenderer::printText2 (layer, value, label, x1, y1, RIGHT_MIDDLE, 5);
+	GchartRenderer::drawSubLine (layer, x1, y1, x2, y1);
+	layer->stroke ();
+	layer->fill ();
+}
+
+void GchartRenderer::printText2 (const Cairo::RefPtr<Cairo::Context>& layer, const float &value, const std::shared_ptr<GchartLabel> &label, const float &x, const float &y, const AllignMode &m, const float &padding) {
+	GchartRenderer::printText (layer, label->getValueUnitText (value), x, y, m, padding);
+}
+
+void GchartRenderer::printText (const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text, const float &x, const float &y, const AllignMode &m, const float &padding) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+
+	float x_new, y_new;
+	Cairo::TextExtents extents;
+
+	GchartTextCache::getDefault ().getTextExtents (layer, text, extents);
+	extents.width += 2 * padding;
+	extents.height += 2 * padding;
+	x_new = x;
+	y_new = y;
+
+	switch(m)
+	{
+		case MIDDLE_TOP:
+			x_new -= extents.width / 2;
+			y_new += extents.height;
+			break;
+		case MIDDLE_MIDDLE:
+			x_new -= extents.width / 2;
+			y_new += extents.height / 2;
+			break;
+		case MIDDLE_BOTTOM:
+			x_new -= extents.width / 2;
+			break;
+		case LEFT_TOP:
+			y_new += extents.height;
+			break;
+		case LEFT_MIDDLE:
+			y_new += extents.height / 2;
+			break;
+		case LEFT_BOTTOM:
+			break;
+		case RIGHT_TOP:
+			x_new -= extents.width;
+			y_new += extents.height;
+			break;
+		case RIGHT_MIDDLE:
+			x_new -= extents.width;
+			y_new += extents.height / 2;
+			break;
+		default:
+		case RIGHT_BOTTOM:
+			x_new -= extents.width / 2;
+			break;
+	}
+
+	GchartTextCache::getDefault ().showText (layer, text, x_new + padding, y_new - padding);
+}
@@ -0,0 +1,238 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartRenderer.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GCHART_RENDERER_HPP__
+#define __GCHART_RENDERER_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cairomm/cairomm.h>
+
+#include "GchartViewport.hpp"
+#include "GchartAutoscale.hpp"
+#include "GchartLabel.hpp"
+#include "GchartPoint.hpp"
+#include "GchartProvider.hpp"
+#include "GchartStats.hpp"
+
+/* Not installed, see sources_private_h in Makefile.am. */
+class GchartHitIndex;
+
+#if _ENABLE_GTK == 4
+#define CAIRO_ENUM_NS_CONTEXT Cairo::Context
+#define CAIRO_ENUM_NS_SURFACE Cairo::Surface
+#elif _ENABLE_GTK == 3
+#define CAIRO_ENUM_NS_CONTEXT Cairo
+#define CAIRO_ENUM_NS_SURFACE Cairo
+#endif
+
+/* Where a buffer that is rendered in slices continues, see
+ * GchartRenderer::drawBufferSlice (). */
+struct GchartRenderSlice {
+	enum Step {
+		STEP_START = 0,
+		STEP_MIN_MAX,
+		STEP_RASTER,
+		STEP_CHART,
+		STEP_DONE
+	};
+
+	Step step;
+	/* STEP_MIN_MAX: the provider (0 is y1, 1 is y2), chart and sample to continue with. */
+	int provider;
+	GchartProvider::const_iterator chart;
+	GchartMap::const_iterator sample;
+	bool chart_started;
+	float y_min, y_max;
+	/* STEP_CHART: the first column of the next band and the band width in pixels. */
+	int column;
+	double band_width;
+	float x_hint;
+	Cairo::RefPtr<Cairo::Context> layer;
+
+	GchartRenderSlice (void) : step(STEP_START), provider(0), chart_started(false), y_min(NAN), y_max(NAN), column(0), band_width(16), x_hint(0) {};
+	~GchartRenderSlice (void) {};
+};
+
+/* The charts of a buffer in follow mode (GchartViewport::x_span), the next
+ * buffer shifts them when nothing but the x range changed and only draws the
+ * new part. It is never changed after the render, so jobs can share it. */
+struct GchartRenderReuse {
+	Cairo::RefPtr<Cairo::ImageSurface> charts;
+	GchartViewport viewport;
+	float y1_min, y1_max, y2_min, y2_max;
+	uint64_t y1_revision, y2_revision;
+	bool has_y2;
+};
+
+/* Everything needed to render one buffer. The providers are private copies
+ * (the chart data itself is shared), so the owner can keep changing its own
+ * providers while the job is running. */
+struct GchartRenderJob {
+	GchartViewport viewport;
+	std::shared_ptr<GchartProvider> y1, y2;
+	std::shared_ptr<GchartLabel> label;
+	Cairo::RefPtr<Cairo::Surface> surface;
+	unsigned int tiles;
+	/* Draw every chart as one simplified path, for vector surfaces. */
+	bool vector;
+	/* Maximum deviation (in device units) of the simplified path. */
+	double tolerance;
+	GchartStats stats;
+	std::atomic<bool> cancelled;
+	/* Only used by drawBufferSlice (). */
+	GchartRenderSlice slice;
+	/* In follow mode: the charts of the buffer before (if any) and of this one. */
+	std::shared_ptr<const GchartRenderReuse> previous;
+	std::shared_ptr<const GchartRenderReuse> reuse;
+	/* Build hits from the finished buffer, for hit testing. */
+	bool hit_index;
+	std::shared_ptr<const GchartHitIndex> hits;
+	/* Kept by the owner from buffer to buffer, the y ranges are updated from
+	 * the buffer before (if set). drawBufferSlice () reads them in chunks. */
+	std::shared_ptr<GchartAutoscale> y1_autoscale, y2_autoscale;
+
+	GchartRenderJob (void) : tiles(1), vector(false), tolerance(0.5), cancelled(false), hit_index(false) {};
+	~GchartRenderJob (void) {};
+
+	bool isCancelled (void) const {
+		return this->cancelled.load (std::memory_order_relaxed);
+	}
+};
+
+/* Draws charts on any Cairo surface without GTK, so charts can be rendered
+ * without a display (image, PDF and SVG surfaces all work). Gchart uses the
+ * same static drawing functions for the widget. */
+class GchartRenderer {
+public:
+	enum AllignMode {
+		RIGHT_BOTTOM = 0, // default
+		MIDDLE_TOP = 1,
+		MIDDLE_MIDDLE,
+		MIDDLE_BOTTOM,
+		LEFT_TOP,
+		LEFT_MIDDLE,
+		LEFT_BOTTOM,
+		RIGHT_TOP,
+		RIGHT_MIDDLE
+	};
+
+private:
+	struct Vertex {
+		double x, y;
+	};
+
+	std::shared_ptr<GchartLabel> _label;
+	std::shared_ptr<GchartProvider> _y1, _y2;
+	GchartViewport _viewport;
+	unsigned int _tiles;
+	GchartStats _stats;
+	std::shared_ptr<GchartAutoscale> _y1_autoscale, _y2_autoscale;
+
+	void render (const Cairo::RefPtr<Cairo::Surface> &surface, const int &width, const int &height, const bool &vector, const double &tolerance);
+	static void simplifyPath (const std::vector<Vertex> &path, const double &tolerance, std::vector<bool> &keep);
+	/* Premultiplied ARGB32 pixel of the density colour map at t (0 to 1). */
+	static uint32_t densityColor (const double &t);
+
+public:
+	GchartRenderer (const std::shared_ptr<GchartLabel> &label, const std::shared_ptr<GchartProvider> &y1, const std::shared_ptr<GchartProvider> &y2 = nullptr);
+	~GchartRenderer (void);
+
+	/* Set zoom, x_center, plot_lines and plot_dots here. After render () it holds the ranges that were drawn. */
+	GchartViewport& getViewport (void);
+	/* Draw in this many vertical strips on GchartThreadPool::getDefault (), 1 draws on the calling thread. */
+	void setTiles (const unsigned int &tiles);
+	const GchartStats& getStats (void) const;
+
+	void render (const Cairo::RefPtr<Cairo::Surface> &surface, const int &width, const int &height);
+	Cairo::RefPtr<Cairo::ImageSurface> render (const int &width, const int &height);
+	/* Render for a vector surface: every chart becomes one path, simplified so it
+	 * deviates at most tolerance device units from the data. */
+	void renderVector (const Cairo::RefPtr<Cairo::Surface> &surface, const int &width, const int &height, const double &tolerance = 0.5);
+	/* Write an SVG or PDF document of width x height points, false if that failed or is not supported by cairo. */
+	bool exportSvg (const std::string &filename, const int &width, const int &height, const double &tolerance = 0.5);
+	bool exportPdf (const std::string &filename, const int &width, const int &height, const double &tolerance = 0.5);
+	/* Surface as used by render (), it can be reused for every render of the same size.
+	 * With a scale it has scale pixels per unit, for HiDPI displays. */
+	static Cairo::RefPtr<Cairo::ImageSurface> createImageSurface (const int &width, const int &height, const int &scale = 1);
+	/* Draw the values at x_info_value in the info box, call it after render (). */
+	void renderInfo (const Cairo::RefPtr<Cairo::Context>& layer, const float &x_info_value) const;
+
+	static void drawBuffer (GchartRenderJob &job);
+	/* Render job for about budget milliseconds and return, call it again until
+	 * it returns true. The surface shows the finished part of the charts once
+	 * job.slice.step is STEP_CHART. Every chart band is at least one pixel
+	 * column wide, so extremely dense charts that are not drawn by
+	 * drawChartMinMax () can take longer than the budget. */
+	static bool drawBufferSlice (GchartRenderJob &job, const double &budget);
+	/* Vertical line at x_value. */
+	static void drawCursor (const Cairo::RefPtr<Cairo::Context>& layer, const GchartViewport &v, const float &x_value);
+	/* Cross hair and circle on a sample at x_coord, y_coord (device units). */
+	static void drawCrosshair (const Cairo::RefPtr<Cairo::Context>& layer, const GchartViewport &v, const double &x_coord, const double &y_coord);
+	static void drawInfo (const Cairo::RefPtr<Cairo::Context>& layer, const GchartViewport &v, const std::shared_ptr<GchartLabel> &label, const std::shared_ptr<GchartProvider> &y1, const std::shared_ptr<GchartProvider> &y2, const float &x_info_value);
+	/* The rows of one provider in the info box, at most max_rows. */
+	static void drawInfoRows (const Cairo::RefPtr<Cairo::Context>& layer, const GchartViewport &v, const std::shared_ptr<GchartProvider> &y, const float &x_info_value, const double &top, const std::size_t &max_rows, const double &text_height, const double &row_height);
+
+	/* Distance between the grid lines of an axis, 0 if there are none. */
+	static double getTickStep (const double &range, const int &lines);
+	static double getXCoord (const GchartViewport &v, const float &x);
+	static double getYCoord (const GchartViewport &v, const float &y, const std::shared_ptr<GchartProvider> &y_provider);
+
+	static void setLineAtributes (const Cairo::RefPtr<Cairo::Context>& layer, const double &width, const CAIRO_ENUM_NS_CONTEXT::LineJoin &line_join, const CAIRO_ENUM_NS_CONTEXT::LineCap &line_cap);
+	static void printText (const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text, const float &x, const float &y, const AllignMode &m, const float &padding);
+
+protected:
+	static void calulateOffsets (GchartRenderJob &job);
+	static void calculateMinMaxValues (GchartRenderJob &job);
+	static void calculateXRange (GchartRenderJob &job);
+	static void setYRange (GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const float &y_min, const float &y_max);
+	static void calculateYRange (GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const std::shared_ptr<GchartAutoscale> &autoscale);
+	static bool sliceMinMax (GchartRenderJob &job, const std::chrono::steady_clock::time_point &deadline);
+	static void drawBand (GchartRenderJob &job, const int &x1, const int &x2);
+	static void drawRaster (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, int &x_lines);
+	static void drawChart (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const float &x_hint, const float &x_from, const float &x_to, GchartStats &stats);
+	/* Draws c as min/max spans per pixel column straight into the image of
+	 * layer, returns false when it does not apply (too few samples per column
+	 * or no ARGB32 image target) so the caller draws the path instead. */
+	static bool drawChartMinMax (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const GchartChart &c, const float &x_from, const float &x_to, GchartStats &stats);
+	/* Calls span (column, lo, hi) for every pixel column from col_from up to
+	 * col_to that c passes between x_from and x_to, with the rows it covers. */
+	static void collectSpans (const GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const GchartChart &c, const float &x_from, const float &x_to, const double &x_offset, const double &y_offset, const int &col_from, const int &col_to, GchartStats &stats, const std::function<void(const int&, const double&, const double&)> &span);
+	/* Counts per pixel how many charts of y pass it and paints the colour
+	 * mapped counts over the plot area. With parallel the counting runs on
+	 * GchartThreadPool::getDefault (), so never call it from a task of that
+	 * pool; without it everything runs on the calling thread. */
+	static void drawChartDensity (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const float &x_from, const float &x_to, const bool &parallel, GchartStats &stats);
+	static void drawChartFollow (const Cairo::RefPtr<Cairo::Context>& layer, GchartRenderJob &job, const float &x_hint);
+	static double getFollowShift (const GchartRenderJob &job, const GchartRenderReuse &previous);
+	static void drawChartTiled (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, const float &x_hint, GchartStats &stats);
+	static void drawChartVector (const Cairo::RefPtr<Cairo::Context>& layer, const GchartRenderJob &job, const std::shared_ptr<GchartProvider> &y, const float &x_hint, GchartStats &stats);
+
+	static void drawSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &x1, const double &y1, const double &x2, const double &y2);
+	static void verticalSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &value, const std::shared_ptr<GchartLabel> &label, const double &x1, const double &y1, const double &y2);
+	static void horizontalSubLine (const Cairo::RefPtr<Cairo::Context>& layer, const double &value, const std::shared_ptr<GchartLabel> &label, const double &x1, const double &y1, const double &x2);
+	static void printText2 (const Cairo::RefPtr<Cairo::Context>& layer, const float &value, const std::shared_ptr<GchartLabel> &label, const float &x, const float &y, const AllignMode &m, const float &padding);
+};
+
+#endif /* __GCHART_RENDERER_HPP__ */
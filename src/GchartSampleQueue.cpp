@@ -0,0 +1,67 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartSampleQueue.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartSampleQueue.hpp"
+
+#include <atomic>
+#include <vector>
+#include <glib.h>
+
+static std::size_t roundCapacity (const std::size_t &capacity) {
+	std::size_t n = 2;
+	while (n < capacity)
+		n <<= 1;
+	return n;
+}
+
+GchartSampleQueue::GchartSampleQueue (const std::size_t &capacity) : _ring(roundCapacity (capacity)), _mask(_ring.size () - 1), _head(0), _tail_seen(0), _tail(0), _dropped(0) {
+	g_debug("%s:%d %s (%zu)", __FILE__, __LINE__, __func__, capacity);
+}
+
+GchartSampleQueue::~GchartSampleQueue (void) {
+	g_debug("%s:%d %s ()", __FILE__, __LINE__, __func__);
+}
+
+bool GchartSampleQueue::push (const bool &y2, const int &identifier, const float &x, const float &y) {
+	const std::size_t head = this->_head.load (std::memory_order_relaxed);
+
+	/* Only look at the consumer counter when the ring seems full. */
+	if (head - this->_tail_seen >= this->_ring.size ()) {
+		this->_tail_seen = this->_tail.load (std::memory_order_acquire);
+		if (head - this->_tail_seen >= this->_ring.size ()) {
+			this->_dropped.fetch_add (1, std::memory_order_relaxed);
+			return false;
+		}
+	}
+	this->_ring[head & this->_mask] = {identifier, y2, x, y};
+	this->_head.store (head + 1, std::memory_order_release);
+	return true;
+}
+
+bool GchartSampleQueue::empty (void) const {
+	return (this->_head.load (std::memory_order_acquire) == this->_tail.load (std::memory_order_relaxed));
+}
+
+uint64_t GchartSampleQueue::getDropped (void) const {
+	return this->_dropped.load (std::memory_order_relaxed);
+}
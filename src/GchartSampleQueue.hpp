@@ -0,0 +1,75 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartSampleQueue.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __GCHART_SAMPLE_QUEUE_HPP__
+#define __GCHART_SAMPLE_QUEUE_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Lock free ring of samples from one producer thread to one consumer (the
+ * main loop of Gchart, see Gchart::createProducer ()). Neither side ever
+ * waits: push () fails when the ring is full and drain () takes what is
+ * there. */
+class GchartSampleQueue {
+public:
+	struct Sample {
+		int identifier;
+		bool y2;
+		float x, y;
+	};
+
+private:
+	/* The counters only grow, the index in the ring is counter & _mask. */
+	std::vector<Sample> _ring;
+	const std::size_t _mask;
+	/* Written by the producer, with its last seen copy of _tail. */
+	std::atomic<std::size_t> _head;
+	std::size_t _tail_seen;
+	char _pad1[64];
+	/* Written by the consumer. */
+	std::atomic<std::size_t> _tail;
+	char _pad2[64];
+	std::atomic<uint64_t> _dropped;
+
+public:
+	/* capacity is rounded up to a power of two. */
+	GchartSampleQueue (const std::size_t &capacity);
+	~GchartSampleQueue (void);
+
+	/* Producer thread only. Returns false (and counts the sample as dropped) when the ring is full. */
+	bool push (const bool &y2, const int &identifier, const float &x, const float &y);
+	/* Consumer only. Calls f (const Sample&) for every queued sample in order, returns how many. */
+	template<typename F>
+	std::size_t drain (F f) {
+		const std::size_t tail = this->_tail.load (std::memory_order_relaxed);
+		const std::size_t head = this->_head.load (std::memory_order_acquire);
+		for (std::size_t i = tail; i != head; ++i)
+			f (this->_ring[i & this->_mask]);
+		this->_tail.store (head, std::memory_order_release);
+		return head - tail;
+	}
+	bool empty (void) const;
+	/* Samples push () could not add, from any thread. */
+	uint64_t getDropped (void) const;
+};
+
+#endif /* __GCHART_SAMPLE_QUEUE_HPP__ */
@@ -0,0 +1,65 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartSeries.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartSeries.hpp"
+
+#include <cmath>
+#include <memory>
+#include <utility>
+
+#include "GchartTrace.hpp"
+
+GchartSeries::GchartSeries (const std::shared_ptr<const GchartMap> &map) : _map(map), _y_min(NAN), _y_max(NAN) {
+	GchartTraceScope trace ("data", "createSeries");
+	for (const auto &v : *this->_map) {
+		if (!std::isfinite (v.second)) continue;
+		if (!std::isfinite (this->_y_min) || v.second < this->_y_min)
+			this->_y_min = v.second;
+		if (!std::isfinite (this->_y_max) || v.second > this->_y_max)
+			this->_y_max = v.second;
+	}
+}
+
+GchartSeries::~GchartSeries (void) {
+	return;
+}
+
+std::shared_ptr<const GchartSeries> GchartSeries::create (GchartMap &&map) {
+	return std::make_shared<const GchartSeries> (std::make_shared<const GchartMap> (std::move (map)));
+}
+
+std::shared_ptr<const GchartSeries> GchartSeries::create (const std::shared_ptr<const GchartMap> &map) {
+	return std::make_shared<const GchartSeries> (map);
+}
+
+const std::shared_ptr<const GchartMap>& GchartSeries::getMap (void) const {
+	return this->_map;
+}
+
+float GchartSeries::getYMin (void) const {
+	return this->_y_min;
+}
+
+float GchartSeries::getYMax (void) const {
+	return this->_y_max;
+}
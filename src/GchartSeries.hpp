@@ -0,0 +1,51 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartSeries.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __GCHART_SERIES_HPP__
+#define __GCHART_SERIES_HPP__
+
+#include <memory>
+
+#include "GchartPoint.hpp"
+
+/* Samples that never change, with what is derived from them computed once.
+ * One series can be shown by any number of charts, providers and Gchart
+ * widgets without copying it. A chart that appends samples copies the data
+ * first (see GchartChart::append ()). */
+class GchartSeries {
+private:
+	std::shared_ptr<const GchartMap> _map;
+	/* Of all finite samples, NAN if there are none. */
+	float _y_min, _y_max;
+
+public:
+	/* The data is shared and not copied, it must not be changed afterwards. */
+	GchartSeries (const std::shared_ptr<const GchartMap> &map);
+	~GchartSeries (void);
+
+	/* Takes the samples over without copying them. */
+	static std::shared_ptr<const GchartSeries> create (GchartMap &&map);
+	static std::shared_ptr<const GchartSeries> create (const std::shared_ptr<const GchartMap> &map);
+
+	const std::shared_ptr<const GchartMap>& getMap (void) const;
+	float getYMin (void) const;
+	float getYMax (void) const;
+};
+
+#endif /* __GCHART_SERIES_HPP__ */
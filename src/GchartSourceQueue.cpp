@@ -0,0 +1,59 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartSourceQueue.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartSourceQueue.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <glibmm.h>
+
+GchartSourceQueue::GchartSourceQueue (void) : _state(std::make_shared<State> ()) {
+	this->_state->ready = &this->_ready;
+}
+
+GchartSourceQueue::~GchartSourceQueue (void) {
+	std::lock_guard<std::mutex> lock (this->_state->mutex);
+	this->_state->ready = nullptr;
+}
+
+GchartDataSource::Fulfil GchartSourceQueue::createFulfil (const bool &y2, const int &identifier, const uint64_t &serial) {
+	std::shared_ptr<State> state = this->_state;
+	return [state, y2, identifier, serial] (const GchartDataRequest &request, const GchartMap &samples) {
+		std::lock_guard<std::mutex> lock (state->mutex);
+		if (state->ready == nullptr) return;
+		state->results.push_back ({y2, identifier, serial, request, samples});
+		state->ready->emit ();
+	};
+}
+
+std::vector<GchartSourceQueue::Result> GchartSourceQueue::takeResults (void) {
+	std::lock_guard<std::mutex> lock (this->_state->mutex);
+	std::vector<Result> results;
+	results.swap (this->_state->results);
+	return results;
+}
+
+Glib::Dispatcher& GchartSourceQueue::signal_ready (void) {
+	return this->_ready;
+}
@@ -0,0 +1,66 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartSourceQueue.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __GCHART_SOURCE_QUEUE_HPP__
+#define __GCHART_SOURCE_QUEUE_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <glibmm.h>
+
+#include "GchartDataSource.hpp"
+
+/* Hands the answers of GchartDataSource::request () from any thread to the
+ * main loop. Answers that come in after the queue is destroyed are dropped. */
+class GchartSourceQueue {
+public:
+	struct Result {
+		bool y2;
+		int identifier;
+		uint64_t serial;
+		GchartDataRequest request;
+		GchartMap samples;
+	};
+
+private:
+	/* Shared with the callbacks, they can outlive the queue. */
+	struct State {
+		std::mutex mutex;
+		std::vector<Result> results;
+		Glib::Dispatcher *ready;
+	};
+
+	std::shared_ptr<State> _state;
+	Glib::Dispatcher _ready;
+
+public:
+	GchartSourceQueue (void);
+	~GchartSourceQueue (void);
+
+	/* Callback for GchartDataSource::request () that queues its answer. */
+	GchartDataSource::Fulfil createFulfil (const bool &y2, const int &identifier, const uint64_t &serial);
+	/* The answers so far, only call this from the main loop. */
+	std::vector<Result> takeResults (void);
+	/* Emitted in the main loop when answers are queued. */
+	Glib::Dispatcher& signal_ready (void);
+};
+
+#endif /* __GCHART_SOURCE_QUEUE_HPP__ */
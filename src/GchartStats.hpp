@@ -0,0 +1,75 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartStats.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GCHART_STATS_HPP__
+#define __GCHART_STATS_HPP__
+
+#include <cstdint>
+
+/* Timings (in microseconds) and counters of one frame. */
+struct GchartStats {
+	enum Stage {
+		STAGE_OFFSETS = 0,
+		STAGE_MIN_MAX,
+		STAGE_RASTER,
+		STAGE_CHART,
+		STAGE_BUFFER,  // all of the above
+		STAGE_OVERLAY,
+		STAGE_INFO,
+		STAGE_FRAME,   // the complete draw handler
+		N_STAGES
+	};
+
+	double time[N_STAGES];
+	uint64_t frame;
+	uint64_t points;      // chart points visited
+	uint64_t vertices;    // path vertices emitted
+	uint64_t allocations; // GchartPoint objects and surfaces created
+	uint64_t columns;     // pixel columns drawn by the min/max rasteriser
+	bool buffer_rendered; // the buffer stages belong to this frame
+
+	GchartStats (void) : frame(0) {
+		this->clear ();
+	};
+	~GchartStats (void) {};
+
+	void clear (void) {
+		for (int i = 0; i < N_STAGES; ++i)
+			this->time[i] = 0.0;
+		this->points = 0;
+		this->vertices = 0;
+		this->allocations = 0;
+		this->columns = 0;
+		this->buffer_rendered = false;
+	}
+
+	/* Add the counters of a part of the buffer, like a strip in tiled mode. */
+	void addCounters (const GchartStats &other) {
+		this->points += other.points;
+		this->vertices += other.vertices;
+		this->allocations += other.allocations;
+		this->columns += other.columns;
+	}
+
+	static const char* getStageName (const Stage &s) {
+		static const char *names[N_STAGES] = {"offsets", "min_max", "raster", "chart", "buffer", "overlay", "info", "frame"};
+		return names[s];
+	}
+};
+
+#endif /* __GCHART_STATS_HPP__ */
@@ -0,0 +1,166 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartTextCache.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartTextCache.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <cairo.h>
+#include <cairomm/cairomm.h>
+
+#include "GchartTrace.hpp"
+
+/* Both caches are simply emptied when they get this big. */
+#define MAX_EXTENTS (8192)
+#define MAX_GLYPHS (2048)
+#define GLYPH_PADDING (1)
+
+#if _ENABLE_GTK == 4
+#define GLYPH_FORMAT Cairo::Surface::Format::A8
+#elif _ENABLE_GTK == 3
+#define GLYPH_FORMAT Cairo::FORMAT_A8
+#endif
+
+std::string GchartTextCache::makeKey (const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text) {
+	cairo_t *cr = layer->cobj ();
+	cairo_font_face_t *face = cairo_get_font_face (cr);
+	cairo_matrix_t m;
+	std::string key;
+
+	cairo_get_font_matrix (cr, &m);
+	if (cairo_font_face_get_type (face) == CAIRO_FONT_TYPE_TOY) {
+		key = cairo_toy_font_face_get_family (face);
+		key += '/' + std::to_string (static_cast<int>(cairo_toy_font_face_get_slant (face)));
+		key += '/' + std::to_string (static_cast<int>(cairo_toy_font_face_get_weight (face)));
+	} else
+		key = std::to_string (reinterpret_cast<std::uintptr_t>(face));
+	key += '/' + std::to_string (m.xx) + '/' + std::to_string (m.yy) + '/';
+	key += text;
+	return key;
+}
+
+void GchartTextCache::getTextExtents (const std::string &key, const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text, Cairo::TextExtents &extents) {
+	{
+		std::lock_guard<std::mutex> lock (this->_mutex);
+		const auto it = this->_extents.find (key);
+		if (it != this->_extents.end ()) {
+			extents = it->second;
+			return;
+		}
+	}
+
+	{
+		GchartTraceScope trace ("cache", "textExtents");
+		layer->get_text_extents (text, extents);
+	}
+
+	std::lock_guard<std::mutex> lock (this->_mutex);
+	if (this->_extents.size () >= MAX_EXTENTS) {
+		GchartTraceScope trace ("cache", "clearExtents");
+		this->_extents.clear ();
+	}
+	this->_extents.emplace (key, extents);
+}
+
+void GchartTextCache::getTextExtents (const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text, Cairo::TextExtents &extents) {
+	this->getTextExtents (GchartTextCache::makeKey (layer, text), layer, text, extents);
+}
+
+void GchartTextCache::showText (const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text, const double &x, const double &y) {
+	/* A mask would end up as a bitmap in vector documents, draw real text there. */
+	if (GchartTextCache::isVectorTarget (layer)) {
+		layer->move_to (x, y);
+		layer->show_text (text);
+		return;
+	}
+
+	/* Glyphs are rendered at the resolution of the target (HiDPI buffers). */
+	double x_scale, y_scale;
+	cairo_surface_get_device_scale (cairo_get_target (layer->cobj ()), &x_scale, &y_scale);
+	const std::string key = GchartTextCache::makeKey (layer, text);
+	const std::string glyphs_key = std::to_string (x_scale) + '/' + std::to_string (y_scale) + '/' + key;
+	Glyphs glyphs;
+	bool found = false;
+
+	{
+		std::lock_guard<std::mutex> lock (this->_mutex);
+		const auto it = this->_glyphs.find (glyphs_key);
+		if (it != this->_glyphs.end ()) {
+			glyphs = it->second;
+			found = true;
+		}
+	}
+
+	if (!found) {
+		GchartTraceScope trace ("cache", "renderGlyphs");
+		Cairo::TextExtents extents;
+		cairo_matrix_t m;
+
+		this->getTextExtents (key, layer, text, extents);
+		const int width = static_cast<int>(std::ceil (extents.width)) + 2 * GLYPH_PADDING;
+		const int height = static_cast<int>(std::ceil (extents.height)) + 2 * GLYPH_PADDING;
+		glyphs.surface = Cairo::ImageSurface::create (GLYPH_FORMAT, static_cast<int>(std::ceil (width * x_scale)), static_cast<int>(std::ceil (height * y_scale)));
+		cairo_surface_set_device_scale (glyphs.surface->cobj (), x_scale, y_scale);
+		glyphs.x_offset = std::floor (extents.x_bearing) - GLYPH_PADDING;
+		glyphs.y_offset = std::floor (extents.y_bearing) - GLYPH_PADDING;
+
+		auto cr = Cairo::Context::create (glyphs.surface);
+		cairo_get_font_matrix (layer->cobj (), &m);
+		cairo_set_font_face (cr->cobj (), cairo_get_font_face (layer->cobj ()));
+		cairo_set_font_matrix (cr->cobj (), &m);
+		cr->move_to (-glyphs.x_offset, -glyphs.y_offset);
+		cr->show_text (text);
+		glyphs.surface->flush ();
+
+		std::lock_guard<std::mutex> lock (this->_mutex);
+		if (this->_glyphs.size () >= MAX_GLYPHS) {
+			GchartTraceScope trace_clear ("cache", "clearGlyphs");
+			this->_glyphs.clear ();
+		}
+		this->_glyphs.emplace (glyphs_key, glyphs);
+	}
+
+	/* Keep the glyphs on whole pixels, otherwise the mask gets blurred. */
+	layer->mask (glyphs.surface, std::round (x * x_scale) / x_scale + glyphs.x_offset, std::round (y * y_scale) / y_scale + glyphs.y_offset);
+}
+
+bool GchartTextCache::isVectorTarget (const Cairo::RefPtr<Cairo::Context>& layer) {
+	const cairo_surface_type_t type = cairo_surface_get_type (cairo_get_target (layer->cobj ()));
+	return (type == CAIRO_SURFACE_TYPE_PDF || type == CAIRO_SURFACE_TYPE_PS || type == CAIRO_SURFACE_TYPE_SVG || type == CAIRO_SURFACE_TYPE_SCRIPT);
+}
+
+void GchartTextCache::clear (void) {
+	std::lock_guard<std::mutex> lock (this->_mutex);
+	this->_extents.clear ();
+	this->_glyphs.clear ();
+}
+
+Cairo::RefPtr<Cairo::Context> GchartTextCache::createMeasureContext (void) {
+	return Cairo::Context::create (Cairo::ImageSurface::create (GLYPH_FORMAT, 1, 1));
+}
+
+GchartTextCache& GchartTextCache::getDefault (void) {
+	static GchartTextCache cache;
+	return cache;
+}
@@ -0,0 +1,61 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartTextCache.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GCHART_TEXT_CACHE_HPP__
+#define __GCHART_TEXT_CACHE_HPP__
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <cairomm/cairomm.h>
+
+/* Process wide cache of text extents and pre-rendered text, keyed by font, size and text
+ * (and for pre-rendered text the device scale of the target).
+ * It is shared by all widgets and can be used from any thread. */
+class GchartTextCache {
+private:
+	struct Glyphs {
+		Cairo::RefPtr<Cairo::ImageSurface> surface;
+		double x_offset, y_offset;
+	};
+
+	std::unordered_map<std::string, Cairo::TextExtents> _extents;
+	std::unordered_map<std::string, Glyphs> _glyphs;
+	std::mutex _mutex;
+
+	static std::string makeKey (const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text);
+	void getTextExtents (const std::string &key, const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text, Cairo::TextExtents &extents);
+
+public:
+	GchartTextCache (void) {};
+	~GchartTextCache (void) {};
+
+	void getTextExtents (const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text, Cairo::TextExtents &extents);
+	/* Same as move_to (x, y) followed by show_text (text), using the current source as colour. */
+	void showText (const Cairo::RefPtr<Cairo::Context>& layer, const std::string &text, const double &x, const double &y);
+	void clear (void);
+
+	/* True for PDF, PostScript, SVG and script surfaces, text on them is never cached. */
+	static bool isVectorTarget (const Cairo::RefPtr<Cairo::Context>& layer);
+
+	/* Small context to measure text with, when there is nothing to draw on yet. */
+	static Cairo::RefPtr<Cairo::Context> createMeasureContext (void);
+	static GchartTextCache& getDefault (void);
+};
+
+#endif /* __GCHART_TEXT_CACHE_HPP__ */
@@ -0,0 +1,82 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartThreadPool.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartThreadPool.hpp"
+
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+GchartThreadPool::GchartThreadPool (unsigned int n_threads) : _quit(false) {
+	if (n_threads == 0)
+		n_threads = std::thread::hardware_concurrency ();
+	if (n_threads == 0)
+		n_threads = 1;
+	for (unsigned int i = 0; i < n_threads; ++i)
+		this->_threads.emplace_back (&GchartThreadPool::run, this);
+}
+
+GchartThreadPool::~GchartThreadPool (void) {
+	{
+		std::lock_guard<std::mutex> lock (this->_mutex);
+		this->_quit = true;
+	}
+	this->_cond.notify_all ();
+	for (std::thread &t : this->_threads)
+		t.join ();
+}
+
+std::future<void> GchartThreadPool::push (std::function<void(void)> task) {
+	std::packaged_task<void(void)> t (std::move (task));
+	std::future<void> f = t.get_future ();
+	{
+		std::lock_guard<std::mutex> lock (this->_mutex);
+		this->_tasks.push_back (std::move (t));
+	}
+	this->_cond.notify_one ();
+	return f;
+}
+
+std::size_t GchartThreadPool::size (void) const noexcept {
+	return this->_threads.size ();
+}
+
+GchartThreadPool& GchartThreadPool::getDefault (void) {
+	static GchartThreadPool pool;
+	return pool;
+}
+
+void GchartThreadPool::run (void) {
+	while (true) {
+		std::packaged_task<void(void)> task;
+		{
+			std::unique_lock<std::mutex> lock (this->_mutex);
+			this->_cond.wait (lock, [this] { return this->_quit || !this->_tasks.empty (); });
+			/* Finish the queued work before quitting, somebody may wait for it. */
+			if (this->_tasks.empty ()) break;
+			task = std::move (this->_tasks.front ());
+			this->_tasks.pop_front ();
+		}
+		task ();
+	}
+}
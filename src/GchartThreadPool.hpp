@@ -0,0 +1,52 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartThreadPool.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GCHART_THREAD_POOL_HPP__
+#define __GCHART_THREAD_POOL_HPP__
+
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+class GchartThreadPool {
+private:
+	std::vector<std::thread> _threads;
+	std::deque<std::packaged_task<void(void)>> _tasks;
+	std::mutex _mutex;
+	std::condition_variable _cond;
+	bool _quit;
+
+	void run (void);
+
+public:
+	/* When n_threads is 0 one thread per core is started. */
+	GchartThreadPool (unsigned int n_threads = 0);
+	~GchartThreadPool (void);
+
+	std::future<void> push (std::function<void(void)> task);
+	std::size_t size (void) const noexcept;
+
+	/* Pool shared by all widgets in the process. Tasks must never wait on other tasks of the same pool. */
+	static GchartThreadPool& getDefault (void);
+};
+
+#endif /* __GCHART_THREAD_POOL_HPP__ */
@@ -0,0 +1,156 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartTrace.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <features.h>
+
+#include "GchartTrace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+std::atomic<bool> GchartTrace::_enabled (false);
+
+GchartTrace::GchartTrace (const std::size_t &size) : _size(size), _events(new Event[size]), _head(0) {
+	this->clear ();
+}
+
+void GchartTrace::setEnabled (const bool enable) {
+	/* Create the buffer before the first event is recorded. */
+	if (enable)
+		GchartTrace::getDefault ();
+	GchartTrace::_enabled.store (enable, std::memory_order_relaxed);
+}
+
+void GchartTrace::begin (const char *category, const char *name) {
+	this->record ('B', category, name);
+}
+
+void GchartTrace::end (const char *category, const char *name) {
+	this->record ('E', category, name);
+}
+
+void GchartTrace::instant (const char *category, const char *name) {
+	this->record ('i', category, name);
+}
+
+void GchartTrace::clear (void) {
+	for (std::size_t i = 0; i < this->_size; ++i)
+		this->_events[i].seq.store (0, std::memory_order_relaxed);
+	this->_head.store (0, std::memory_order_release);
+}
+
+void GchartTrace::record (const char &phase, const char *category, const char *name) {
+	const uint64_t n = this->_head.fetch_add (1, std::memory_order_relaxed);
+	Event &e = this->_events[n % this->_size];
+
+	/* Sequence lock: a reader only uses the event if seq did not change while reading it. */
+	e.seq.store (2 * n + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence (std::memory_order_release);
+	e.category.store (category, std::memory_order_relaxed);
+	e.name.store (name, std::memory_order_relaxed);
+	e.ts.store (GchartTrace::now (), std::memory_order_relaxed);
+	e.tid.store (GchartTrace::threadId (), std::memory_order_relaxed);
+	e.phase.store (phase, std::memory_order_relaxed);
+	e.seq.store (2 * n + 2, std::memory_order_release);
+}
+
+uint64_t GchartTrace::now (void) {
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+	return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start).count ();
+}
+
+uint32_t GchartTrace::threadId (void) {
+	static std::atomic<uint32_t> next (1);
+	static thread_local uint32_t id = next.fetch_add (1, std::memory_order_relaxed);
+	return id;
+}
+
+void GchartTrace::writeString (std::ostream &out, const char *s) {
+	out << '"';
+	for (; s != nullptr && *s != '\0'; ++s) {
+		if (*s == '"' || *s == '\\')
+			out << '\\';
+		out << *s;
+	}
+	out << '"';
+}
+
+void GchartTrace::dump (std::ostream &out) const {
+	struct Copy {
+		const char *category, *name;
+		uint64_t ts;
+		uint32_t tid;
+		char phase;
+	};
+	std::vector<Copy> events;
+	events.reserve (this->_size);
+
+	for (std::size_t i = 0; i < this->_size; ++i) {
+		const Event &e = this->_events[i];
+		const uint64_t seq = e.seq.load (std::memory_order_acquire);
+		if (seq == 0 || (seq & 1) != 0) continue;
+		Copy c;
+		c.category = e.category.load (std::memory_order_relaxed);
+		c.name = e.name.load (std::memory_order_relaxed);
+		c.ts = e.ts.load (std::memory_order_relaxed);
+		c.tid = e.tid.load (std::memory_order_relaxed);
+		c.phase = e.phase.load (std::memory_order_relaxed);
+		std::atomic_thread_fence (std::memory_order_acquire);
+		/* Skip events that were overwritten while copying them. */
+		if (e.seq.load (std::memory_order_relaxed) != seq) continue;
+		events.push_back (c);
+	}
+	std::sort (events.begin (), events.end (), [] (const Copy &a, const Copy &b) { return a.ts < b.ts; });
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (std::size_t i = 0; i < events.size (); ++i) {
+		const Copy &c = events[i];
+		if (i > 0)
+			out << ',';
+		out << "\n{\"name\":";
+		GchartTrace::writeString (out, c.name);
+		out << ",\"cat\":";
+		GchartTrace::writeString (out, c.category);
+		out << ",\"ph\":\"" << c.phase << "\",\"ts\":" << (c.ts / 1000) << '.' << std::to_string (1000 + c.ts % 1000).substr (1);
+		out << ",\"pid\":1,\"tid\":" << c.tid;
+		if (c.phase == 'i')
+			out << ",\"s\":\"t\"";
+		out << '}';
+	}
+	out << "\n]}\n";
+}
+
+bool GchartTrace::dump (const std::string &filename) const {
+	std::ofstream out (filename);
+	if (!out) return false;
+	this->dump (out);
+	return static_cast<bool>(out);
+}
+
+GchartTrace& GchartTrace::getDefault (void) {
+	static GchartTrace trace;
+	return trace;
+}
@@ -0,0 +1,111 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartTrace.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GCHART_TRACE_HPP__
+#define __GCHART_TRACE_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "GchartStats.hpp"
+
+/* Records begin/end events in a fixed size ring buffer, the oldest events are
+ * overwritten. Recording is lock free and can be done from any thread, when
+ * tracing is disabled it costs a single atomic load. The buffer can be written
+ * as Chrome trace event JSON, which can be opened in Perfetto or chrome://tracing.
+ * Names and categories are not copied, so only pass string literals. */
+class GchartTrace {
+private:
+	struct Event {
+		/* Odd while the event is written, 0 if it was never written. */
+		std::atomic<uint64_t> seq;
+		std::atomic<const char*> category;
+		std::atomic<const char*> name;
+		std::atomic<uint64_t> ts;
+		std::atomic<uint32_t> tid;
+		std::atomic<char> phase;
+	};
+
+	static std::atomic<bool> _enabled;
+
+	const std::size_t _size;
+	std::unique_ptr<Event[]> _events;
+	std::atomic<uint64_t> _head;
+
+	void record (const char &phase, const char *category, const char *name);
+	static uint64_t now (void);
+	static uint32_t threadId (void);
+	static void writeString (std::ostream &out, const char *s);
+
+public:
+	GchartTrace (const std::size_t &size = 65536);
+	~GchartTrace (void) {};
+
+	static void setEnabled (const bool enable);
+	static bool isEnabled (void) {
+		return GchartTrace::_enabled.load (std::memory_order_relaxed);
+	}
+
+	void begin (const char *category, const char *name);
+	void end (const char *category, const char *name);
+	void instant (const char *category, const char *name);
+	void clear (void);
+
+	/* Write the recorded events in the Chrome trace event format. */
+	void dump (std::ostream &out) const;
+	bool dump (const std::string &filename) const;
+
+	static GchartTrace& getDefault (void);
+};
+
+/* Records a begin event on construction and the end event on destruction. */
+class GchartTraceScope {
+private:
+	const char *_category, *_name;
+	const bool _active;
+
+public:
+	GchartTraceScope (const char *category, const char *name) : _category(category), _name(name), _active(GchartTrace::isEnabled ()) {
+		if (this->_active)
+			GchartTrace::getDefault ().begin (this->_category, this->_name);
+	};
+	~GchartTraceScope (void) {
+		if (this->_active)
+			GchartTrace::getDefault ().end (this->_category, this->_name);
+	};
+};
+
+/* Adds the time between construction and destruction to a stage, and traces the stage. */
+class GchartStatsTimer {
+private:
+	double &_time;
+	const GchartTraceScope _trace;
+	const std::chrono::steady_clock::time_point _start;
+
+public:
+	GchartStatsTimer (GchartStats &stats, const GchartStats::Stage &s) : _time(stats.time[s]), _trace("render", GchartStats::getStageName (s)), _start(std::chrono::steady_clock::now ()) {};
+	~GchartStatsTimer (void) {
+		this->_time += std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now () - this->_start).count ();
+	};
+};
+
+#endif /* __GCHART_TRACE_HPP__ */
@@ -0,0 +1,72 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * GchartViewport.hpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GCHART_VIEWPORT_HPP__
+#define __GCHART_VIEWPORT_HPP__
+
+#include <cmath>
+
+/* Plain copy of all the view parameters a buffer is rendered with.
+ * A copy is taken for every render so it can be used away from the widget. */
+struct GchartViewport {
+	int width, height;
+	float offset_left, offset_right, offset_top, offset_bottom, infobox_width;
+	float x_max, x_min, x_scale;
+	float zoom, x_center;
+	bool plot_lines, plot_dots;
+	/* Charts with more samples per pixel column than minmax_threshold are drawn
+	 * as a min/max span per column directly in the image (0 disables it), with
+	 * anti aliased span ends when minmax_coverage is set. */
+	float minmax_threshold;
+	bool minmax_coverage;
+	/* When not 0 the x axis follows the newest sample and shows this span,
+	 * zoom and x_center are not used. */
+	float x_span;
+	/* Draw a density map of how many charts pass every pixel instead of the
+	 * charts themselves, for many overlapping charts. */
+	bool density;
+	/* Image pixels per device unit, like Gtk::Widget::get_scale_factor (). */
+	int scale;
+
+	GchartViewport (void) : width(0), height(0), offset_left(0), offset_right(0), offset_top(0), offset_bottom(0), infobox_width(0), x_max(NAN), x_min(NAN), x_scale(1.0), zoom(1.0), x_center(NAN), plot_lines(true), plot_dots(true), minmax_threshold(4.0), minmax_coverage(true), x_span(0), density(false), scale(1) {};
+	~GchartViewport (void) {};
+
+	bool inPlotArea (const double &x, const double &y) const {
+		return (x >= this->offset_left && x <= (this->width - this->offset_right) && y >= this->offset_top && y <= (this->height - this->offset_bottom));
+	}
+
+	/* The x value at device coordinate x_coord. */
+	float getXValue (const double &x_coord) const {
+		return this->x_min + ((x_coord - this->offset_left) / this->x_scale);
+	}
+
+	/* Vertical scrolling zooms in or out around x_pointer, horizontal scrolling pans. */
+	void scroll (const double &dx, const double &dy, const float &x_pointer) {
+		if (this->x_span > 0) {
+			/* Following, only the span can change. */
+			this->x_span *= std::pow (1.1f, static_cast<float>(dy));
+		} else if (dy == 0) {
+			this->x_center += dx * (this->x_max - this->x_min);
+		} else {
+			this->zoom += -dy;
+			this->x_center = x_pointer;
+		}
+	}
+};
+
+#endif /* __GCHART_VIEWPORT_HPP__ */
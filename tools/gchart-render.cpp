@@ -0,0 +1,319 @@
+/* kate: indent-mode cstyle; tab-width 4; indent-width 4; */
+/*
+ * gchart-render.cpp
+ * Copyright (C) Martijn Goedhart 2022 <goedhart.martijn@gmail.com>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Renders many charts to PNG files in parallel, without a display.
+ *
+ * Usage: gchart-render [-j threads] [-q] jobfile
+ *
+ * Every line of the job file describes one chart:
+ *   output.png width height y1=series [y1=series ...] [y2=series ...] [key=value ...]
+ * Other keys are x_label, x_unit, y1_label, y1_unit, y2_label, y2_unit,
+ * zoom, center (the x value in the middle when zoomed), lines and dots (0 or 1).
+ * Values can not contain spaces. Empty lines and lines starting with # are skipped.
+ *
+ * A series file has one "x y" pair per line, separated by spaces, tabs or a comma.
+ * Every series file is read once, charts using the same file share the data.
+ *
+ * Outputs ending in .svg or .pdf are written as simplified vector documents.
+ *
+ * For every job the render and PNG write times are printed (in ms), failed jobs
+ * are reported and make the exit status 1. */
+
+#include "config.h"
+
+#include <features.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <cairomm/cairomm.h>
+
+#include "GchartColor.hpp"
+#include "GchartLabel.hpp"
+#include "GchartProvider.hpp"
+#include "GchartRenderer.hpp"
+#include "GchartThreadPool.hpp"
+
+struct RenderJob {
+	int line;
+	std::string output;
+	int width, height;
+	std::string x_label, x_unit, y1_label, y1_unit, y2_label, y2_unit;
+	std::vector<std::string> y1, y2;
+	float zoom, x_center;
+	bool lines, dots;
+
+	RenderJob (void) : line(0), width(0), height(0), x_label("x"), y1_label("y1"), y2_label("y2"), zoom(1.0), x_center(NAN), lines(true), dots(false) {};
+};
+
+struct RenderResult {
+	bool ok;
+	std::string error;
+	double render_ms, write_ms;
+
+	RenderResult (void) : ok(false), render_ms(0), write_ms(0) {};
+};
+
+typedef std::map<std::string, std::shared_ptr<const GchartMap>> SeriesCache;
+
+static const GchartColor palette[] = {
+	{0.8, 0, 0}, {0, 0, 0.8}, {0, 0.6, 0}, {0.8, 0.5, 0}, {0.5, 0, 0.6}, {0, 0.6, 0.6}
+};
+
+static std::shared_ptr<const GchartMap> readSeries (const std::string &filename) {
+	std::ifstream in (filename);
+	std::string line;
+	auto map = std::make_shared<GchartMap> ();
+
+	if (!in) return nullptr;
+	while (std::getline (in, line)) {
+		const char *s = line.c_str ();
+		char *end;
+		while (*s == ' ' || *s == '\t') ++s;
+		if (*s == '\0' || *s == '#') continue;
+		const float x = std::strtof (s, &end);
+		if (end == s) continue;
+		s = end;
+		while (*s == ' ' || *s == '\t' || *s == ',') ++s;
+		const float y = std::strtof (s, &end);
+		if (end == s) continue;
+		map->emplace (x, y);
+	}
+	return map;
+}
+
+static bool parseJob (const std::string &line, RenderJob &job, std::string &error) {
+	std::istringstream in (line);
+	std::string word;
+
+	if (!(in >> job.output >> job.width >> job.height) || job.width <= 0 || job.height <= 0) {
+		error = "expected: output width height";
+		return false;
+	}
+	while (in >> word) {
+		const std::size_t eq = word.find ('=');
+		if (eq == std::string::npos) {
+			error = "expected key=value, got " + word;
+			return false;
+		}
+		const std::string key = word.substr (0, eq);
+		const std::string value = word.substr (eq + 1);
+		if (key == "y1") job.y1.push_back (value);
+		else if (key == "y2") job.y2.push_back (value);
+		else if (key == "x_label") job.x_label = value;
+		else if (key == "x_unit") job.x_unit = value;
+		else if (key == "y1_label") job.y1_label = value;
+		else if (key == "y1_unit") job.y1_unit = value;
+		else if (key == "y2_label") job.y2_label = value;
+		else if (key == "y2_unit") job.y2_unit = value;
+		else if (key == "zoom") job.zoom = std::strtof (value.c_str (), nullptr);
+		else if (key == "center") job.x_center = std::strtof (value.c_str (), nullptr);
+		else if (key == "lines") job.lines = (value != "0");
+		else if (key == "dots") job.dots = (value != "0");
+		else {
+			error = "unknown key " + key;
+			return false;
+		}
+	}
+	if (job.y1.empty ()) {
+		error = "no y1 series";
+		return false;
+	}
+	return true;
+}
+
+static std::shared_ptr<GchartProvider> createProvider (const std::vector<std::string> &files, const std::string &label, const std::string &unit, const SeriesCache &series, std::string &error) {
+	auto provider = std::make_shared<GchartProvider> (label, unit, &GchartLabel::defaultPrint);
+	int n = 0;
+
+	for (const std::string &f : files) {
+		const auto it = series.find (f);
+		if (it == series.end () || !it->second || it->second->empty ()) {
+			error = "can not read series " + f;
+			return nullptr;
+		}
+		provider->addChart (GchartChart::Type::LINEAR, n, palette[n % (sizeof (palette) / sizeof (palette[0]))], it->second, nullptr);
+		++n;
+	}
+	return provider;
+}
+
+static RenderResult render (const RenderJob &job, const SeriesCache &series) {
+	/* One surface per worker, it is only recreated when the size changes. */
+	static thread_local Cairo::RefPtr<Cairo::ImageSurface> surface;
+	RenderResult result;
+	std::shared_ptr<GchartProvider> y1, y2;
+
+	y1 = createProvider (job.y1, job.y1_label, job.y1_unit, series, result.error);
+	if (!y1) return result;
+	if (!job.y2.empty ()) {
+		y2 = createProvider (job.y2, job.y2_label, job.y2_unit, series, result.error);
+		if (!y2) return result;
+	}
+
+	const std::size_t dot = job.output.rfind ('.');
+	const std::string extension = (dot == std::string::npos) ? "" : job.output.substr (dot);
+
+	GchartRenderer renderer (std::make_shared<GchartLabel> (job.x_label, job.x_unit), y1, y2);
+	GchartViewport &v = renderer.getViewport ();
+	v.zoom = job.zoom;
+	v.x_center = job.x_center;
+	v.plot_lines = job.lines;
+	v.plot_dots = job.dots;
+
+	try {
+		if (extension == ".svg" || extension == ".pdf") {
+			const auto t0 = std::chrono::steady_clock::now ();
+			result.ok = (extension == ".svg") ? renderer.exportSvg (job.output, job.width, job.height) : renderer.exportPdf (job.output, job.width, job.height);
+			result.render_ms = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - t0).count ();
+			if (!result.ok)
+				result.error = "can not write vector output";
+			return result;
+		}
+
+		if (!surface || surface->get_width () != job.width || surface->get_height () != job.height)
+			surface = GchartRenderer::createImageSurface (job.width, job.height);
+
+		const auto t0 = std::chrono::steady_clock::now ();
+		renderer.render (surface, job.width, job.height);
+		const auto t1 = std::chrono::steady_clock::now ();
+		surface->write_to_png (job.output);
+		const auto t2 = std::chrono::steady_clock::now ();
+
+		result.render_ms = std::chrono::duration<double, std::milli> (t1 - t0).count ();
+		result.write_ms = std::chrono::duration<double, std::milli> (t2 - t1).count ();
+		result.ok = true;
+	} catch (const std::exception &e) {
+		result.error = e.what ();
+	}
+	return result;
+}
+
+static void usage (const char *name) {
+	std::fprintf (stderr, "Usage: %s [-j threads] [-q] jobfile\n", name);
+}
+
+int main (int argc, char* argv[]) {
+	unsigned int n_threads = 0;
+	bool quiet = false;
+	int opt, failed = 0;
+
+	while ((opt = getopt (argc, argv, "j:qh")) != -1) {
+		switch (opt) {
+			case 'j':
+				n_threads = std::strtoul (optarg, nullptr, 10);
+				break;
+			case 'q':
+				quiet = true;
+				break;
+			default:
+				usage (argv[0]);
+				return (opt == 'h') ? 0 : 2;
+		}
+	}
+	if (optind != argc - 1) {
+		usage (argv[0]);
+		return 2;
+	}
+
+	std::ifstream in (argv[optind]);
+	if (!in) {
+		std::fprintf (stderr, "%s: can not open %s\n", argv[0], argv[optind]);
+		return 2;
+	}
+
+	const auto start = std::chrono::steady_clock::now ();
+	std::vector<RenderJob> jobs;
+	SeriesCache series;
+	std::string line;
+	int line_nr = 0;
+
+	while (std::getline (in, line)) {
+		++line_nr;
+		const std::size_t first = line.find_first_not_of (" \t\r");
+		if (first == std::string::npos || line[first] == '#') continue;
+		RenderJob job;
+		std::string error;
+		job.line = line_nr;
+		if (!parseJob (line, job, error)) {
+			std::fprintf (stderr, "%s:%d: %s\n", argv[optind], line_nr, error.c_str ());
+			++failed;
+			continue;
+		}
+		for (const std::string &f : job.y1)
+			series[f];
+		for (const std::string &f : job.y2)
+			series[f];
+		jobs.push_back (job);
+	}
+
+	/* Renderer tiles run on the default pool, so the jobs get a pool of their own. */
+	GchartThreadPool pool (n_threads);
+
+	/* Read every series file once, in parallel. */
+	{
+		std::vector<std::future<void>> tasks;
+		for (auto &s : series) {
+			auto *entry = &s;
+			tasks.push_back (pool.push ([entry] () { entry->second = readSeries (entry->first); }));
+		}
+		for (std::future<void> &t : tasks)
+			t.get ();
+	}
+	const auto loaded = std::chrono::steady_clock::now ();
+
+	std::vector<std::future<RenderResult>> results;
+	results.reserve (jobs.size ());
+	for (const RenderJob &job : jobs) {
+		auto task = std::make_shared<std::promise<RenderResult>> ();
+		results.push_back (task->get_future ());
+		pool.push ([&job, &series, task] () { task->set_value (render (job, series)); });
+	}
+
+	double render_total = 0, write_total = 0;
+	std::size_t done = 0;
+	for (std::size_t i = 0; i < jobs.size (); ++i) {
+		const RenderResult r = results[i].get ();
+		if (!r.ok) {
+			std::fprintf (stderr, "%s:%d: %s: %s\n", argv[optind], jobs[i].line, jobs[i].output.c_str (), r.error.c_str ());
+			++failed;
+			continue;
+		}
+		++done;
+		render_total += r.render_ms;
+		write_total += r.write_ms;
+		if (!quiet)
+			std::printf ("%s\t%.3f\t%.3f\n", jobs[i].output.c_str (), r.render_ms, r.write_ms);
+	}
+
+	const auto end = std::chrono::steady_clock::now ();
+	const double wall = std::chrono::duration<double> (end - start).count ();
+	std::fprintf (stderr, "%zu charts, %d failed, %zu series read in %.3f s, %zu threads\n", done, failed, series.size (), std::chrono::duration<double> (loaded - start).count (), pool.size ());
+	std::fprintf (stderr, "wall %.3f s, %.1f charts/s, render %.3f s, png %.3f s (summed over threads)\n", wall, (wall > 0) ? done / wall : 0.0, render_total / 1000, write_total / 1000);
+	return (failed > 0) ? 1 : 0;
+}